@@ -0,0 +1,26 @@
+/*
+ * bench.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_BENCH_H_
+#define INC_BENCH_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Registers the "bench" command, before Command_Init
+ * @note	Benchmarks run on the command task, timed by DWT CYCCNT, and log their
+ * 			results. They are for the bench, not for a running controller.
+ */
+void Bench_Init(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* INC_BENCH_H_ */
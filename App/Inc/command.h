@@ -0,0 +1,67 @@
+/*
+ * command.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_COMMAND_H_
+#define INC_COMMAND_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Command handler
+ * @param	Argc	Number of words on the line, including the command name
+ * @param	pArgv	Words on the line, pArgv[0] is the command name
+ */
+typedef void (*Command_Handler)(int Argc, char *pArgv[]);
+
+/**
+ * @brief	Registers a command, lines starting with Name are passed to Handler
+ * @note	Must be called before Command_Init
+ * @param	Name	Command name, must outlive the registration
+ * @param	Handler	Function called from the command task
+ * @param	Usage	One line usage text listed by "help"
+ * @retval	false	Command table full
+ */
+bool Command_Register(const char *Name, Command_Handler Handler, const char *Usage);
+
+/**
+ * @brief	Feeds received bytes to the command line
+ * @note	Interrupt only, from interrupts that can't preempt each other
+ */
+void Command_ReceiveFromISR(const uint8_t *pData, size_t Length);
+
+/**
+ * @brief	USART1 receive complete interrupt callback
+ */
+void Command_ReceiveCompleteInterruptCallback(void);
+
+/**
+ * @brief	USART1 error interrupt callback, restarts reception
+ * @note	An overrun ends the HAL's reception, the command line would go deaf
+ */
+void Command_ErrorInterruptCallback(void);
+
+/**
+ * @brief	Command FreeRTOS task
+ */
+void Command_Task(void *pvParameters);
+
+/**
+ * @brief	Initialises command task and starts listening on USART1
+ */
+void Command_Init(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* INC_COMMAND_H_ */
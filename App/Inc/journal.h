@@ -0,0 +1,65 @@
+/*
+ * journal.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_JOURNAL_H_
+#define INC_JOURNAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Journal entry types
+ */
+typedef enum
+{
+	Journal_Boot = 1,	// RCC reset flags, written once per boot
+	Journal_Log,		// Rendered log record at or above LOG_JOURNAL_LEVEL
+	Journal_Snapshot	// Journal_SnapshotData
+} Journal_EntryType;
+
+/**
+ * @brief	Sensor reading kept in the journal
+ */
+typedef struct
+{
+	uint8_t Sensor;
+	uint8_t Valid;
+	int8_t Temperature;		// Degrees C
+	uint8_t Humidity;		// % RH
+} Journal_SnapshotData;
+
+/**
+ * @brief	Queues an entry for the journal task to write to flash
+ * @note	Task context only, copies the data and returns without touching flash
+ * @param	Type	Entry type
+ * @param	pData	Entry payload
+ * @param	Length	Payload length, at most 255 bytes
+ * @retval	false	Journal not initialised or batch full, entry dropped
+ */
+bool Journal_Append(Journal_EntryType Type, const void *pData, size_t Length);
+
+/**
+ * @brief	Journal FreeRTOS task
+ */
+void Journal_Task(void *pvParameters);
+
+/**
+ * @brief	Finds where the journal left off and starts the journal task
+ * @note	Must be called before Command_Init
+ */
+void Journal_Init(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* INC_JOURNAL_H_ */
@@ -9,43 +9,328 @@
 #define INC_LOGGER_H_
 
 #include <stdint.h>
+#include <stdarg.h>
+
+#if defined(__cplusplus)
+#include <type_traits>
+#endif
 
 #include "cmsis_os2.h"
 
-#include "stm32f1xx_hal.h"
-#include "stm32f1xx_hal_uart.h"
+#include "timebase.h"
 
-#include "usbd_cdc_if.h"
+#include "logger_modules.h"
+#include "logger_sink.h"
 
 #define LOGGER			Logger::Instance()
 
 #define ENABLE_LOGGING
 
-//#define LOG_TO_USB	/* Untested!! */
-#define LOG_TO_UART
-//#define LOG_TO_PRINTF	/* Untested!! */
+// Sinks enabled at boot, each can be switched at runtime with "log sink <name> on|off"
+#define LOG_TO_UART1		true
+#define LOG_TO_USB			false
+#define LOG_TO_SEMIHOSTING	false	/* Stops the core if the debugger has semihosting disabled */
+
+// Ships format ID + raw arguments instead of text, decode with Tools/log_decode.py
+//#define LOG_BINARY
+
+// Compile-time floor of modules that don't pick their own with FilteredLoggerModule
+#define LOG_DEFAULT_LEVEL	LogLevel::Debug
+
+// Records at or above this level are also appended to the flash journal
+#define LOG_JOURNAL_LEVEL	LogLevel::Warn
+
+/**
+ * @brief	Logs a formatted message from a logger module at a severity level
+ * @note	Format must be a string literal. Levels below the module's compile-time floor
+ * 			are discarded by the compiler, arguments are not evaluated and the format
+ * 			string never reaches flash. Levels below the runtime threshold skip the
+ * 			arguments too. In binary mode the literal is moved to the non-loaded
+ * 			.logfmt section and only its offset is stored on the target.
+ */
+#define LOG_AT(pModule, Level, Format, ...)	\
+	LOGGER_FILTER(pModule, Level, LOGGER_EMIT(pModule, Level, Format __VA_OPT__(,) __VA_ARGS__))
+
+#define LOG_TRACE(pModule, Format, ...)		LOG_AT(pModule, LogLevel::Trace, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_DEBUG(pModule, Format, ...)		LOG_AT(pModule, LogLevel::Debug, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_INFO(pModule, Format, ...)		LOG_AT(pModule, LogLevel::Info, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARN(pModule, Format, ...)		LOG_AT(pModule, LogLevel::Warn, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(pModule, Format, ...)		LOG_AT(pModule, LogLevel::Error, Format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief	Logs from an interrupt, see Logger::LogFromISR
+ * @note	At most four arguments of 32 bits. %s arguments must point at strings that
+ * 			outlive the record, e.g. literals.
+ */
+#define LOG_ISR_AT(pModule, Level, Format, ...)	\
+	LOGGER_FILTER(pModule, Level, LOGGER_EMIT_ISR(pModule, Level, Format __VA_OPT__(,) __VA_ARGS__))
+
+#define LOG_ISR_TRACE(pModule, Format, ...)	LOG_ISR_AT(pModule, LogLevel::Trace, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ISR_DEBUG(pModule, Format, ...)	LOG_ISR_AT(pModule, LogLevel::Debug, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ISR_INFO(pModule, Format, ...)	LOG_ISR_AT(pModule, LogLevel::Info, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ISR_WARN(pModule, Format, ...)	LOG_ISR_AT(pModule, LogLevel::Warn, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ISR_ERROR(pModule, Format, ...)	LOG_ISR_AT(pModule, LogLevel::Error, Format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief	Logs as LOG_AT, at most Burst messages from this call site and then one per PeriodMs
+ * @note	For hot sites that would flood the arena. Suppressed messages are counted in the
+ * 			module's limited counter, arguments are not evaluated.
+ */
+#define LOG_LIMITED_AT(pModule, Level, Burst, PeriodMs, Format, ...)	\
+	LOGGER_FILTER(pModule, Level,	\
+		LOGGER_LIMIT(pModule, Burst, PeriodMs, LOGGER_EMIT(pModule, Level, Format __VA_OPT__(,) __VA_ARGS__)))
+
+/**
+ * @brief	Logs as LOG_ISR_AT, rate limited per call site as LOG_LIMITED_AT
+ */
+#define LOG_ISR_LIMITED_AT(pModule, Level, Burst, PeriodMs, Format, ...)	\
+	LOGGER_FILTER(pModule, Level,	\
+		LOGGER_LIMIT(pModule, Burst, PeriodMs, LOGGER_EMIT_ISR(pModule, Level, Format __VA_OPT__(,) __VA_ARGS__)))
+
+/**
+ * @brief	Runs Emit only if Level passes the module's compile-time floor and runtime threshold
+ */
+#if !defined(ENABLE_LOGGING)
+#define LOGGER_FILTER(pModule, Level, Emit)
+#else
+#define LOGGER_FILTER(pModule, Level, Emit)	\
+	do	\
+	{	\
+		if constexpr ((Level) >= LOGGER_COMPILE_LEVEL(pModule))	\
+		{	\
+			if ((pModule)->IsEnabled(Level))	\
+			{	\
+				Emit;	\
+			}	\
+		}	\
+	} while (0)
+#endif
+
+/**
+ * @brief	Runs Emit only if the call site's own rate limiter has a token left
+ */
+#define LOGGER_LIMIT(pModule, Burst, PeriodMs, Emit)	\
+	do	\
+	{	\
+		static LogRateLimiter s_RateLimit(Burst, PeriodMs);	\
+		if (s_RateLimit.Allow())	\
+		{	\
+			Emit;	\
+		}	\
+		else	\
+		{	\
+			(pModule)->CountLimited();	\
+		}	\
+	} while (0)
+
+/**
+ * @brief	Gets the compile-time floor of a logger module pointer's type
+ */
+#define LOGGER_COMPILE_LEVEL(pModule)	std::remove_cvref_t<decltype(*(pModule))>::s_CompileLevel
+
+#if defined(LOG_BINARY)
+#define LOGGER_EMIT(pModule, Level, Format, ...)		LOGGER.LogB(pModule, Level, LOGGER_FORMAT_ID(Format) __VA_OPT__(,) __VA_ARGS__)
+#define LOGGER_EMIT_ISR(pModule, Level, Format, ...)	LOGGER.LogFromISR(pModule, Level, LOGGER_FORMAT_ID(Format) __VA_OPT__(,) __VA_ARGS__)
+#else
+#define LOGGER_EMIT(pModule, Level, Format, ...)		LOGGER.LogF(pModule, Level, Format __VA_OPT__(,) __VA_ARGS__)
+#define LOGGER_EMIT_ISR(pModule, Level, Format, ...)	\
+	LOGGER.LogFromISR(pModule, Level, (uint32_t)(uintptr_t)(Format) __VA_OPT__(,) __VA_ARGS__)
+#endif
+
+/**
+ * @brief	Places a format string literal in .logfmt and yields its offset as ID
+ */
+#define LOGGER_FORMAT_ID(Format)	\
+	([]() -> uint32_t	\
+	{	\
+		static const char s_Format[] __attribute__((section(".logfmt"), used)) = Format;	\
+		return (uint32_t)(uintptr_t)s_Format;	\
+	}())
 
 #if defined(__cplusplus)
 /**
- * @class	Logger type
- * @brief	Handles storing/flushing log messages
+ * @brief	Log severity levels, lowest first
+ */
+enum class LogLevel : uint8_t
+{
+	Trace,
+	Debug,
+	Info,
+	Warn,
+	Error,
+	None		// Threshold only, disables every level
+};
+
+/**
+ * @brief	What a module does with a new record when the log arena is full
+ */
+enum class LogPolicy : uint8_t
+{
+	DropNewest,			// Discard the new record
+	OverwriteOldest,	// Evict the oldest unflushed records to make room
+	Block				// Wait up to the module timeout for space, interrupts drop instead
+};
+
+/**
+ * @class	Per call site token bucket, see LOG_LIMITED_AT
+ * @brief	Holds up to Burst tokens, one more is earned every PeriodMs
+ * @note	Constant initialised so function-local instances need no guard. Not locked,
+ * 			a race between contexts costs at most an extra message.
+ */
+class LogRateLimiter
+{
+public:
+	constexpr LogRateLimiter(uint16_t Burst, uint32_t PeriodMs) :
+		m_Burst(Burst),
+		m_Tokens(Burst),
+		m_PeriodMs(PeriodMs),
+		m_LastRefill(0)
+	{
+	}
+
+	/**
+	 * @brief	Takes a token if one is left
+	 * @retval	true	The message may go out
+	 */
+	bool Allow(void);
+
+private:
+	const uint16_t m_Burst;
+	uint16_t m_Tokens;
+	const uint32_t m_PeriodMs;
+
+	// HAL tick the tokens were last topped up at
+	uint32_t m_LastRefill;
+};
+
+/**
+ * @brief	Logger module IDs, see LOGGER_MODULES
+ */
+enum class LogModuleId : uint8_t
+{
+#define LOGGER_MODULE_ID(Id, Name)	Id,
+	LOGGER_MODULES(LOGGER_MODULE_ID)
+#undef LOGGER_MODULE_ID
+	Count
+};
+
+/**
+ * @class	Logger module descriptor
+ * @brief	Identifies the source of log records, declare as constexpr
+ * @note	Only the ID goes into records. Runtime state (threshold and counters) is kept
+ * 			per ID by the logger, so any number of descriptors can share a module.
  */
 class LoggerModule
 {
 public:
 	// Constructors/destructors
-	LoggerModule(const char * ModuleName);
-	~LoggerModule();
+	/**
+	 * @brief	Constructor
+	 * @param	Id				Module ID from LOGGER_MODULES
+	 * @param	Policy			What to do when the arena is full
+	 * @param	BlockTimeoutMs	Longest wait for space with LogPolicy::Block
+	 */
+	constexpr LoggerModule(LogModuleId Id, LogPolicy Policy = LogPolicy::DropNewest, uint32_t BlockTimeoutMs = 0) :
+		m_Id(Id),
+		m_Policy(Policy),
+		m_BlockTimeoutMs(BlockTimeoutMs)
+	{
+	}
+
+	/**
+	 * @brief Gets module ID
+	 */
+	constexpr LogModuleId GetId(void) const
+	{
+		return m_Id;
+	}
 
 	/**
 	 * @brief Gets module name as C-style string pointer
+	 * @note  Points into flash, which lets the host decoder resolve it from the ELF
 	 */
 	const char * GetModuleName(void) const;
 
+	/**
+	 * @brief Gets the name of a module ID
+	 */
+	static const char * GetModuleName(LogModuleId Id);
+
+	/**
+	 * @brief Gets arena full policy
+	 */
+	LogPolicy GetPolicy(void) const;
+
+	/**
+	 * @brief Gets longest wait for space with LogPolicy::Block
+	 */
+	uint32_t GetBlockTimeoutMs(void) const;
+
+	/**
+	 * @brief Sets the runtime threshold, levels below the compile-time floor stay discarded
+	 */
+	void SetLevel(LogLevel Level) const;
+
+	/**
+	 * @brief Gets the runtime threshold
+	 */
+	LogLevel GetLevel(void) const;
+
+	/**
+	 * @brief Counts a message suppressed by a call site rate limit
+	 */
+	void CountLimited(void) const;
+
+	/**
+	 * @brief Checks a level against the runtime threshold
+	 */
+	bool IsEnabled(LogLevel Level) const
+	{
+		return (Level >= s_States[(size_t)m_Id].Level);
+	}
+
+	// Longest rendered prefix, the name and a colon
 	static constexpr size_t s_MaxModuleNameLength = 8;
 
+	// Levels below this are compiled out, derived types may hide it with their own
+	static constexpr LogLevel s_CompileLevel = LOG_DEFAULT_LEVEL;
+
 private:
-	char m_ModuleName[s_MaxModuleNameLength + 1];
+	friend class Logger;
+
+	/**
+	 * @brief	Runtime state of a module ID
+	 * @note	Counters are records queued, records that never made it out, messages
+	 * 			cut short and messages held back by rate limits. Updated atomically by
+	 * 			the logger from any context.
+	 */
+	struct State
+	{
+		volatile LogLevel Level;
+		volatile uint32_t Emitted;
+		volatile uint32_t Dropped;
+		volatile uint32_t Truncated;
+		volatile uint32_t Limited;
+	};
+
+	static State s_States[(size_t)LogModuleId::Count];
+
+	const LogModuleId m_Id;
+	const LogPolicy m_Policy;
+	const uint32_t m_BlockTimeoutMs;
+};
+
+/**
+ * @class	Logger module with its own compile-time floor
+ * @brief	Levels below CompileLevel are discarded at every LOG_* call site of the module
+ */
+template <LogLevel CompileLevel>
+class FilteredLoggerModule : public LoggerModule
+{
+public:
+	using LoggerModule::LoggerModule;
+
+	static constexpr LogLevel s_CompileLevel = CompileLevel;
 };
 
 /**
@@ -63,22 +348,143 @@ public:
 
 	/**
 	 * @brief Prints a formatted log string
+	 * @note  Safe to call from any context, only blocks for modules with LogPolicy::Block
+	 * @param pModule	pointer to logger module
+	 * @param Level		severity of the message
+	 * @retval false	Queue full, message dropped
+	 */
+	bool LogF(const LoggerModule *const pModule, LogLevel Level, const char *Format, ...);
+
+	/**
+	 * @brief Records a binary log message, formatted on the host
+	 * @note  Safe to call from any context, only blocks for modules with LogPolicy::Block
 	 * @param pModule	pointer to logger module
+	 * @param Level		severity of the message
+	 * @param FormatId	format string ID from LOGGER_FORMAT_ID
+	 * @param Arguments	format arguments, each must fit in 32 bits
+	 * @retval false	Queue full, message dropped
 	 */
-	bool LogF(const LoggerModule *const pModule, const char *Format, ...);
+	template <typename... Args>
+	bool LogB(const LoggerModule *const pModule, LogLevel Level, uint32_t FormatId, Args... Arguments)
+	{
+		static_assert(sizeof...(Args) <= s_MaxArguments, "Too many binary log arguments");
+		static_assert(((sizeof(Args) <= sizeof(uint32_t)) && ...), "Binary log arguments must fit in 32 bits");
+
+		const uint32_t Words[] = { FormatId, ToWord(Arguments)... };
+		return LogWords(pModule, Level, Timebase_GetCycles(), Words, sizeof...(Args) + 1);
+	}
+
+	/**
+	 * @brief Queues a small fixed record from an interrupt, the logger task formats it later
+	 * @note  Wait-free, no formatting and no locks. Costs a scan of at most s_IsrRings
+	 * 		  busy flags, a 64-bit timestamp and a ten word copy, roughly 100 cycles by
+	 * 		  instruction count. The first record after the logger task goes idle also pays
+	 * 		  for one task notification. "bench log" measures it on the target, both
+	 * 		  uncontended and in the worst case, every other ring full and a wakeup due.
+	 * 		  Only call from interrupts allowed to use FreeRTOS FromISR functions.
+	 * @param pModule	pointer to logger module
+	 * @param Level		severity of the message
+	 * @param FormatId	format string address, or ID from LOGGER_FORMAT_ID in binary mode
+	 * @param Arguments	up to s_MaxIsrArguments format arguments, each must fit in 32 bits
+	 * @retval false	Every ring busy or full, message dropped
+	 */
+	template <typename... Args>
+	bool LogFromISR(const LoggerModule *const pModule, LogLevel Level, uint32_t FormatId, Args... Arguments)
+	{
+		static_assert(sizeof...(Args) <= s_MaxIsrArguments, "Too many interrupt log arguments");
+		static_assert(((sizeof(Args) <= sizeof(uint32_t)) && ...), "Interrupt log arguments must fit in 32 bits");
+
+		const uint32_t Words[s_MaxIsrArguments] = { ToWord(Arguments)... };
+		return LogWordsFromISR(pModule, Level, FormatId, Words, sizeof...(Args));
+	}
 
 	/**
 	 * @brief Flushes contents of log buffer
+	 * @note  Must only be called from the logger task
 	 */
 	void Flush(void);
 
 	/**
-	 * @brief UART Tx complete interrupt callback
+	 * @brief Blocks the logger task until there is something to flush
+	 * @note  Must only be called from the logger task
+	 */
+	void WaitForWork(void);
+
+	/**
+	 * @brief Moves interrupt records into the arena, oldest first
+	 * @note  Must only be called from the logger task
+	 */
+	void DrainISR(void);
+
+	/**
+	 * @brief Logs the counters of every module once per summary period
+	 * @note  Must only be called from the logger task. Only modules whose counters
+	 * 		  moved since the last summary are logged, the rest would just take up
+	 * 		  arena space the logger task can't wait for.
+	 */
+	void Summarise(void);
+
+	/**
+	 * @brief Sink Tx complete interrupt callback
 	 */
 	void TransmitComplete(void);
 
+	/**
+	 * @brief Stops records from waking the logger task
+	 * @note  For fault handlers and asserts, which run above the kernel or with it broken
+	 */
+	void Panic(void);
+
+	/**
+	 * @brief Prepares the arena to survive a reset, nothing may be logged afterwards
+	 * @note  The arena is cut at the first uncommitted record, then sealed with a magic
+	 * 		  and CRC for the next boot to find.
+	 */
+	void Seal(void);
+
+	/**
+	 * @brief Gets number of records recovered from before the last reset
+	 */
+	size_t GetRecovered(void) const;
+
+	/**
+	 * @brief Adds a sink to stream output to
+	 * @note  Must be called before the logger task starts
+	 * @retval false	Sink table full
+	 */
+	bool AddSink(LoggerSink *pSink);
+
+	/**
+	 * @brief Gets number of sinks added
+	 */
+	size_t GetNumSinks(void) const;
+
+	/**
+	 * @brief Gets a sink by index
+	 */
+	LoggerSink *GetSink(size_t Idx) const;
+
+	/**
+	 * @brief Gets a sink by name
+	 * @retval nullptr	No sink with that name
+	 */
+	LoggerSink *FindSink(const char *Name) const;
+
+	/**
+	 * @brief Times interrupt logging, for the "bench log" command
+	 * @note  Each call runs with interrupts disabled and its record is discarded
+	 * @param Contended	Every ring but the last full and the logger task idle, the worst case
+	 * @param Runs		Calls timed
+	 * @param pFastest	Cycles of the fastest call
+	 * @param pSlowest	Cycles of the slowest call
+	 */
+	void BenchmarkFromISR(bool Contended, size_t Runs, uint32_t *pFastest, uint32_t *pSlowest);
+
 	// RTOS task handle
-	osThreadId_t m_TaskHandle;
+	osThreadId_t m_TaskHandle = nullptr;
+
+	// Set by the flusher after freeing space while LogPolicy::Block producers wait
+	osEventFlagsId_t m_SpaceFlags = nullptr;
 
 private:
 
@@ -87,18 +493,369 @@ private:
 	~Logger();
 
 	// Constants
-	static constexpr size_t s_MaxMessageLength = 64;
-	static constexpr size_t s_QueueSize = 8;
+	static constexpr size_t s_MaxMessageLength = 128;
+	static constexpr size_t s_MaxArguments = 12;
+	static constexpr size_t s_ArenaSize = 1024;
+	static constexpr size_t s_MaxIsrArguments = 4;
+
+	static_assert((s_ArenaSize & (s_ArenaSize - 1)) == 0, "Arena size must be a power of two");
 
 	static constexpr char s_NewLine[] = "\r\n";
 
-	// Queue/queue position pointers
-	char m_Buff[2][s_QueueSize][s_MaxMessageLength + 2];
-	uint8_t m_CurrentBuff;
-	uint8_t m_BuffPos;
+	// Binary frames: sync byte, payload length, then LEB128 payload
+	static constexpr uint8_t s_FrameSync = 0xA5;
+	static constexpr uint32_t s_TextFormatId = 0;
+
+	static constexpr uint32_t s_SpaceFreedFlag = 0x01;
+	static constexpr uint32_t s_SummaryPeriodMs = 60000;
+
+	// Longest a run of identical records is held back before its repeat count goes out
+	static constexpr uint32_t s_RepeatTimeoutMs = 5000;
+
+	// Room for the rendered repeat notice in text mode
+	static constexpr size_t s_RepeatsPayloadWords = 12;
+
+	// Payload bytes compared when hashes match, with equal lengths a collision that
+	// also matches these is beyond practical
+	static constexpr size_t s_RepeatCompareLength = 32;
+
+	// Marks an arena sealed by Seal, "LOGS"
+	static constexpr uint32_t s_SealMagic = 0x4C4F4753;
+
+	enum class RecordType : uint8_t
+	{
+		Text,
+		Binary
+	};
+
+	enum class RecordState : uint8_t
+	{
+		Free,		// Space handed out, header not written yet
+		Reserved,	// Producer is filling the payload
+		Committed,	// Ready to be flushed
+		Padding		// Skipped space at the end of the arena
+	};
+
+	/**
+	 * @brief	Arena record, payload follows directly after it
+	 * @note	Header packs the allocated size (word multiple), state, type, level and
+	 * 			module ID into one word so the flusher never sees it half written. Text
+	 * 			payloads are NUL terminated, binary payloads are the format ID followed by
+	 * 			argument words.
+	 */
+	struct Record
+	{
+		volatile uint32_t Header;
+		uint32_t TimestampLow;
+		uint32_t TimestampHigh;
+
+		static constexpr uint32_t MakeHeader(size_t Size, RecordState State, RecordType Type,
+				LogLevel Level = LogLevel::Trace, LogModuleId Module = (LogModuleId)0)
+		{
+			return Size | ((uint32_t)State << 12) | ((uint32_t)Type << 16) | ((uint32_t)Level << 20) |
+					((uint32_t)Module << 24);
+		}
 
-	// UART driver handle
-	UART_HandleTypeDef *m_UART;
+		static constexpr size_t GetSize(uint32_t Header) { return Header & 0xFFF; }
+		static constexpr RecordState GetState(uint32_t Header) { return (RecordState)((Header >> 12) & 0x0F); }
+		static constexpr RecordType GetType(uint32_t Header) { return (RecordType)((Header >> 16) & 0x0F); }
+		static constexpr LogLevel GetLevel(uint32_t Header) { return (LogLevel)((Header >> 20) & 0x0F); }
+		static constexpr LogModuleId GetModule(uint32_t Header) { return (LogModuleId)(Header >> 24); }
+
+		// Split in two words, the arena only guarantees word alignment
+		void SetTimestamp(uint64_t Cycles) { TimestampLow = (uint32_t)Cycles; TimestampHigh = (uint32_t)(Cycles >> 32); }
+		uint64_t GetTimestamp(void) const { return ((uint64_t)TimestampHigh << 32) | TimestampLow; }
+
+		char *Message(void) { return (char *)(this + 1); }
+		const char *Message(void) const { return (const char *)(this + 1); }
+		uint32_t *Words(void) { return (uint32_t *)(this + 1); }
+		const uint32_t *Words(void) const { return (const uint32_t *)(this + 1); }
+	};
+
+	static_assert((sizeof(Record) % sizeof(uint32_t)) == 0, "Records must keep payloads word aligned");
+	static_assert(s_ArenaSize <= 0x1000, "Record sizes must fit in 12 bits");
+	static_assert((size_t)LogModuleId::Count <= 0x100, "Module IDs must fit in 8 bits");
+
+	// Worst case rendered record: timestamp, module prefix and framing plus a full text message
+	static constexpr size_t s_MaxFrameLength = 32 + s_MaxMessageLength;
+
+	// Rendered records are streamed into a shared output ring that every sink reads at its own pace
+	static constexpr size_t s_OutputSize = 512;
+	static constexpr size_t s_MaxSinks = 4;
+
+	static_assert((s_OutputSize & (s_OutputSize - 1)) == 0, "Output size must be a power of two");
+
+	// Interrupt records wait in rings until the logger task moves them into the arena.
+	// Interrupts that log at the same time can only be nested, so each ring needs to
+	// serve one writer at a time: one that finds a ring busy has preempted its writer
+	// and moves on to the next. s_IsrRings is the logging nesting depth supported.
+	static constexpr size_t s_IsrRings = 3;
+	static constexpr size_t s_IsrRingLength = 8;
+
+	static_assert((s_IsrRingLength & (s_IsrRingLength - 1)) == 0, "Interrupt ring length must be a power of two");
+
+	struct IsrRecord
+	{
+		const LoggerModule *pModule;
+		uint32_t FormatId;
+		uint32_t TimestampLow;
+		uint32_t TimestampHigh;
+		uint8_t NumWords;
+		LogLevel Level;
+		uint32_t Words[s_MaxIsrArguments];
+	};
+
+	struct IsrRing
+	{
+		IsrRecord Records[s_IsrRingLength];
+		volatile uint32_t Head;		// Written by the interrupt holding Busy
+		volatile uint32_t Tail;		// Written by the logger task
+		volatile uint32_t Busy;
+	};
+
+	/**
+	 * @brief	Converts a binary log argument to a raw word
+	 */
+	template <typename T>
+	static uint32_t ToWord(T Value)
+	{
+		if constexpr (std::is_pointer_v<T>)
+		{
+			return (uint32_t)(uintptr_t)Value;
+		}
+		else
+		{
+			return (uint32_t)Value;
+		}
+	}
+
+	/**
+	 * @brief	Queues a text record
+	 * @param	Timestamp	Cycle count the message was logged at
+	 */
+	bool LogV(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const char *Format, va_list Args);
+
+	/**
+	 * @brief	Queues a text record with a given timestamp
+	 */
+	bool LogStampedF(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const char *Format, ...);
+
+	/**
+	 * @brief	Queues a binary record
+	 * @param	Timestamp	Cycle count the message was logged at
+	 * @param	pWords		Format ID followed by argument words
+	 * @param	NumWords	Number of words
+	 */
+	bool LogWords(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const uint32_t *pWords,
+			size_t NumWords);
+
+	/**
+	 * @brief	Copies an interrupt record into the first free ring
+	 */
+	bool LogWordsFromISR(const LoggerModule *const pModule, LogLevel Level, uint32_t FormatId, const uint32_t *pWords,
+			size_t NumWords);
+
+	/**
+	 * @brief	Checks if any interrupt ring holds records
+	 */
+	bool IsIsrPending(void) const;
+
+	/**
+	 * @brief	Reserves arena space for a record without locking
+	 * @param	Length	Record length in bytes including the record header
+	 * @retval	Pointer to reserved record, nullptr if the arena is full
+	 */
+	Record *Reserve(size_t Length, RecordType Type);
+
+	/**
+	 * @brief	Reserves arena space, applying the module policy if the arena is full
+	 * @retval	Pointer to reserved record, nullptr if the record was dropped
+	 */
+	Record *Acquire(const LoggerModule *const pModule, size_t Length, RecordType Type);
+
+	/**
+	 * @brief	Drops the oldest record if it is ready to be flushed
+	 * @retval	true	Space was freed
+	 */
+	bool Evict(void);
+
+	/**
+	 * @brief	Retries a reservation until the flusher frees enough space
+	 * @retval	Pointer to reserved record, nullptr on timeout or if the caller can't block
+	 */
+	Record *WaitForSpace(size_t Length, RecordType Type, uint32_t TimeoutMs);
+
+	/**
+	 * @brief	Takes ownership of the arena tail, shared by the flusher and evicting producers
+	 * @retval	true	Lock taken
+	 */
+	bool TryLockTail(void);
+
+	/**
+	 * @brief	Hands back ownership of the arena tail
+	 */
+	void UnlockTail(void);
+
+	/**
+	 * @brief	Publishes a reserved record and wakes the logger task if it is idle
+	 */
+	void Commit(Record *pRecord, LogLevel Level, LogModuleId Module);
+
+	/**
+	 * @brief	Zeroes the oldest record and hands its space back to producers
+	 */
+	void Release(Record *pRecord, size_t Size);
+
+	/**
+	 * @brief	Wakes the logger task, from a task or an interrupt
+	 */
+	void Wake(void);
+
+	/**
+	 * @brief	Wakes the logger task if this is the first record since it went idle
+	 */
+	void WakeIfIdle(void);
+
+	/**
+	 * @brief	Gets the oldest record in the arena
+	 */
+	Record *Oldest(void) const;
+
+	/**
+	 * @brief	Checks if the oldest record is ready to be flushed
+	 */
+	bool IsPending(void) const;
+
+	/**
+	 * @brief	Keeps the records of an arena sealed before the reset
+	 * @retval	false	No valid seal, the arena holds whatever was in RAM
+	 */
+	bool Recover(void);
+
+	/**
+	 * @brief	Calculates the CRC over the arena, its head and tail and the seal magic
+	 */
+	uint32_t CalculateSealCrc(void) const;
+
+	/**
+	 * @brief	Encodes a record as a binary frame
+	 * @retval	Frame length in bytes
+	 */
+	size_t EncodeFrame(const Record *pRecord, uint8_t *pFrame);
+
+	/**
+	 * @brief	Renders a record in the configured output format
+	 * @retval	Rendered length in bytes
+	 */
+	size_t Render(const Record *pRecord, uint8_t *pOut);
+
+	/**
+	 * @brief	Gets the length of what a record says, its text or its binary payload
+	 */
+	static size_t PayloadLength(const Record *pRecord);
+
+	/**
+	 * @brief	Hashes what makes two records the same message: module, level, type and payload
+	 */
+	static uint32_t HashRecord(const Record *pRecord);
+
+	/**
+	 * @brief	Checks a record against the last one rendered
+	 * @note	The hash only rejects quickly, a match is confirmed on the kept copy
+	 */
+	bool IsRepeat(const Record *pRecord, uint32_t Hash) const;
+
+	/**
+	 * @brief	Keeps what's needed to tell repeats of a rendered record from collisions
+	 */
+	void RememberRecord(const Record *pRecord, uint32_t Hash);
+
+	/**
+	 * @brief	Renders the repeat count of the current run of identical records and ends it
+	 * @retval	Rendered length in bytes
+	 */
+	size_t RenderRepeats(uint8_t *pOut);
+
+	/**
+	 * @brief	Renders the oldest committed record into the carry-over frame
+	 * @retval	false	Nothing left to render
+	 */
+	bool RenderNext(void);
+
+	/**
+	 * @brief	Gets the output position of the sink furthest ahead
+	 * @note	Rendering never overwrites output this sink hasn't sent yet
+	 */
+	uint32_t LeadingCursor(void) const;
+
+	/**
+	 * @brief	Starts the next transfer of a sink if it is idle and behind
+	 * @retval	true	Transfer started
+	 */
+	bool ServiceSink(LoggerSink *pSink);
+
+	// Multi-producer single-consumer record arena, head and tail count bytes.
+	// Free space is kept zeroed so a record header only appears once written.
+	// The logger lives in .noinit, these survive a reset and are checked by Recover.
+	alignas(uint32_t) uint8_t m_Arena[s_ArenaSize];
+	volatile uint32_t m_Head;
+	volatile uint32_t m_Tail;
+	uint32_t m_SealMagic;
+	uint32_t m_SealCrc;
+
+	// Records recovered from before the last reset
+	size_t m_Recovered;
+
+	// Set by Panic, nothing may call into the kernel any more
+	volatile bool m_Panicked;
+
+	// Held while the tail record is copied out or evicted
+	volatile uint32_t m_TailLock;
+
+	// Producers waiting in WaitForSpace
+	volatile uint32_t m_SpaceWaiters;
+
+	// Tick of the last counter summary, and the sum of each module's counters then.
+	// Counters only go up, so a module whose sum is unchanged has nothing new.
+	uint32_t m_LastSummaryTick;
+	uint32_t m_SummaryTotals[(size_t)LogModuleId::Count];
+
+	IsrRing m_IsrRings[s_IsrRings];
+
+	// Last binary frame timestamp, flusher only
+	uint64_t m_LastTimestamp;
+
+	// Rendered output shared by all sinks, head counts bytes ever written. A sink that
+	// falls a whole output behind skips ahead rather than hold back the others.
+	uint8_t m_Output[s_OutputSize];
+	uint32_t m_OutputHead;
+
+	// Rendered record being copied into the output, the rest waits for room
+	uint8_t m_Frame[s_MaxFrameLength];
+	size_t m_FrameLength;
+	size_t m_FrameOffset;
+
+	// Set when rendering stopped for lack of output room
+	bool m_OutputStalled;
+
+	// Runs of identical records are collapsed into one repeat count, flusher only.
+	// Hash, module, level and type, payload length and payload start of the last
+	// rendered record, identical ones that followed it, the tick of the first of them
+	// and the timestamp and module of the latest.
+	uint32_t m_LastHash;
+	uint32_t m_LastKey;
+	size_t m_LastLength;
+	uint8_t m_LastPrefix[s_RepeatCompareLength];
+	uint32_t m_Repeats;
+	uint64_t m_RepeatTimestamp;
+	uint32_t m_RepeatTick;
+	LogModuleId m_RepeatModule;
+
+	LoggerSink *m_Sinks[s_MaxSinks];
+	size_t m_NumSinks;
+
+	// Set while the logger task sleeps, first producer to clear it wakes it up
+	volatile uint32_t m_Idle;
 
 	// Prevent singleton clones
 	Logger(const Logger&) = delete;
@@ -121,6 +878,25 @@ void Logger_Task(void *pvParamaters);
  */
 void Logger_Init(void);
 
+/**
+ * @brief Logs a register dump and resets, keeping the log for the next boot
+ * @note  Call first thing in a fault handler
+ * @param Name		Fault name
+ * @param ExcReturn	LR on entry to the handler
+ */
+void Logger_Fault(const char *Name, uint32_t ExcReturn) __attribute__((noreturn));
+
+/**
+ * @brief Logs a failed assert and resets, keeping the log for the next boot
+ */
+void Logger_AssertFailed(const char *File, int Line) __attribute__((noreturn));
+
+/**
+ * @brief Logs a task's stack overflow and resets, keeping the log for the next boot
+ * @note  Called from vApplicationStackOverflowHook
+ */
+void Logger_StackOverflow(const char *pTaskName) __attribute__((noreturn));
+
 #if defined(__cplusplus)
 }
 #endif
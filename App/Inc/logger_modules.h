@@ -0,0 +1,29 @@
+/*
+ * logger_modules.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_LOGGER_MODULES_H_
+#define INC_LOGGER_MODULES_H_
+
+/**
+ * @brief	Every logger module, X(Id, Name)
+ * @note	Records store the module as a one byte ID, so there can be at most 256.
+ * 			Names are at most seven characters and only looked up when a record is
+ * 			rendered. Add new modules at the end to keep IDs stable for recovered logs.
+ */
+#define LOGGER_MODULES(X)	\
+	X(Logger,	"Logger")	\
+	X(Fault,	"Fault")	\
+	X(Command,	"Command")	\
+	X(Journal,	"Journal")	\
+	X(Test,		"Test")		\
+	X(DHT,		"DHT")	\
+	X(Sensor,	"Sensor")	\
+	X(OneWire,	"1-Wire")	\
+	X(I2c,		"I2C")	\
+	X(Bench,	"Bench")
+
+#endif /* INC_LOGGER_MODULES_H_ */
@@ -0,0 +1,144 @@
+/*
+ * logger_sink.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_LOGGER_SINK_H_
+#define INC_LOGGER_SINK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f1xx_hal.h"
+#include "stm32f1xx_hal_uart.h"
+
+#include "usbd_cdc_if.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	Logger sink type
+ * @brief	Output the logger streams rendered records to
+ * @note	Each sink sends from its own buffer, so the logger can keep rendering into the
+ * 			shared output while it transmits. Completion must call
+ * 			Logger_TransmitCompleteInterruptCallback.
+ */
+class LoggerSink
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	Name	Name used by the "log sink" command
+	 * @param	Enabled	Whether the sink starts enabled
+	 */
+	LoggerSink(const char *Name, bool Enabled);
+
+	/**
+	 * @brief	Gets sink name
+	 */
+	const char *GetName(void) const;
+
+	/**
+	 * @brief	Enables or disables the sink, takes effect on the next flush
+	 */
+	void SetEnabled(bool Enabled);
+
+	/**
+	 * @brief	Checks if the sink is enabled
+	 */
+	bool IsEnabled(void) const;
+
+	/**
+	 * @brief	Gets number of bytes skipped because the sink fell too far behind
+	 */
+	uint32_t GetDropped(void) const;
+
+	/**
+	 * @brief	Checks if the output is there to send to, e.g. a USB host is attached
+	 */
+	virtual bool IsAvailable(void) const;
+
+	/**
+	 * @brief	Checks if the sink is still sending its buffer
+	 */
+	virtual bool IsBusy(void) const = 0;
+
+	/**
+	 * @brief	Starts sending Length bytes of the sink buffer
+	 * @retval	false	Output refused the transfer
+	 */
+	virtual bool Transmit(size_t Length) = 0;
+
+	// Largest transfer, a multiple of the USB packet size so USB transfers go out as full packets
+	static constexpr size_t s_BufferSize = 128;
+
+	static_assert((s_BufferSize % CDC_DATA_FS_MAX_PACKET_SIZE) == 0, "Sink buffers must be whole USB packets");
+
+protected:
+	~LoggerSink() = default;
+
+	uint8_t m_Buffer[s_BufferSize];
+
+private:
+	friend class Logger;
+
+	const char *const m_pName;
+	volatile bool m_Enabled;
+
+	// Position in the logger output stream, logger task only
+	uint32_t m_Cursor;
+	volatile uint32_t m_Dropped;
+};
+
+/**
+ * @class	UART logger sink
+ * @brief	Sends with DMA if the UART has a Tx DMA channel linked, interrupts otherwise
+ */
+class UartLoggerSink : public LoggerSink
+{
+public:
+	UartLoggerSink(const char *Name, bool Enabled, UART_HandleTypeDef *pUART);
+
+	bool IsBusy(void) const override;
+	bool Transmit(size_t Length) override;
+
+private:
+	UART_HandleTypeDef *const m_pUART;
+};
+
+/**
+ * @class	USB CDC logger sink
+ * @brief	Sends to the CDC IN endpoint while a host has the device configured
+ */
+class UsbLoggerSink : public LoggerSink
+{
+public:
+	UsbLoggerSink(const char *Name, bool Enabled);
+
+	bool IsAvailable(void) const override;
+	bool IsBusy(void) const override;
+	bool Transmit(size_t Length) override;
+};
+
+/**
+ * @class	Semihosting logger sink
+ * @brief	Writes to the debugger console, only while a debugger is attached
+ * @note	Halts the core for every transfer, and stops it dead if the debugger
+ * 			doesn't have semihosting enabled
+ */
+class SemihostingLoggerSink : public LoggerSink
+{
+public:
+	SemihostingLoggerSink(const char *Name, bool Enabled);
+
+	bool IsAvailable(void) const override;
+	bool IsBusy(void) const override;
+	bool Transmit(size_t Length) override;
+
+private:
+	int32_t m_Handle;
+};
+#endif /* __cplusplus */
+
+#endif /* INC_LOGGER_SINK_H_ */
@@ -0,0 +1,148 @@
+/*
+ * sensor_cache.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef INC_SENSOR_CACHE_H_
+#define INC_SENSOR_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#if defined(__cplusplus)
+#include "dht.h"
+
+/**
+ * @brief	Sensor reading as kept by a SensorCache
+ */
+struct SensorReading
+{
+	int16_t Temperature;			// Tenths of a degree C
+	uint16_t Humidity;				// Tenths of a % RH
+	uint32_t Tick;					// Kernel tick the reading was taken at
+	bool Valid;						// Never read successfully if false
+};
+
+/**
+ * @class	SensorCacheBase
+ * @brief	Reading and lock of a SensorCache, whatever its sensor type
+ */
+class SensorCacheBase
+{
+public:
+	/**
+	 * @brief	Gets the cached reading without reading the sensor
+	 */
+	SensorReading Peek(void) const;
+
+	// Caches listed by the "sensor" command
+	static constexpr size_t s_MaxCaches = 4;
+	static SensorCacheBase *s_pCaches[s_MaxCaches];
+	static volatile size_t s_NumCaches;
+
+protected:
+	/**
+	 * @brief	Constructor, registers the cache with the "sensor" command
+	 * @param	MinIntervalMs	Shortest time between two reads of the sensor
+	 */
+	SensorCacheBase(uint32_t MinIntervalMs);
+
+	/**
+	 * @brief	Checks if the cache must read its sensor to satisfy MaxAgeMs
+	 * @note	Caller holds the lock
+	 */
+	bool NeedsRead(uint32_t MaxAgeMs) const;
+
+	/**
+	 * @brief	Stores the result of a read
+	 * @note	Caller holds the lock
+	 */
+	void Update(const DhtMeasurement &Measurement, bool Valid);
+
+	/**
+	 * @brief	Checks if the cached reading satisfies MaxAgeMs
+	 * @note	Caller holds the lock
+	 */
+	bool IsFresh(uint32_t MaxAgeMs) const;
+
+	const uint32_t m_MinIntervalMs;
+
+	// Held for the whole of an acquisition, callers queueing on it join the read
+	StaticSemaphore_t m_LockControlBlock;
+	SemaphoreHandle_t m_Lock;
+
+	SensorReading m_Reading;
+
+	// Tick of the last read, valid or not, and whether there was one
+	uint32_t m_LastReadTick;
+	bool m_EverRead;
+};
+
+/**
+ * @class	SensorCache
+ * @brief	Last valid reading of a sensor, shared by every consumer
+ * @note	Consumers ask for a reading no older than a maximum age. A cached reading
+ * 			young enough costs nothing, otherwise the caller acquires a new one and
+ * 			callers arriving meanwhile wait for it and share it. A sensor is never
+ * 			read more often than its model's minimum interval, however many
+ * 			consumers it has.
+ *
+ * 			Sensor is a DhtSensor, or any type with its s_QueueLength, s_MinIntervalMs,
+ * 			multi-sensor ReadBlocking and Decode.
+ */
+template <typename Sensor>
+class SensorCache : public SensorCacheBase
+{
+public:
+	/**
+	 * @brief	Constructor, registers the cache with the "sensor" command
+	 * @param	pSensor		Sensor to cache, read by nothing else
+	 */
+	SensorCache(Sensor *pSensor);
+
+	/**
+	 * @brief	Gets a reading no older than MaxAgeMs
+	 * @note	Task context, blocks while a reading is acquired
+	 * @param	pReading	Set to the freshest reading there is, even if too old
+	 * @retval	false		No valid reading young enough, the sensor failed or
+	 * 						was read too recently to read again
+	 */
+	bool Get(SensorReading *pReading, uint32_t MaxAgeMs);
+
+	/**
+	 * @brief	Gets readings of several caches, see Get
+	 * @note	Sensors that need reading are read in one round. Caches are locked
+	 * 			in order, every caller must pass them in the same order.
+	 * @param	ppCaches	Caches to read, at most Sensor::s_QueueLength
+	 * @param	pReadings	Set to the freshest reading of each cache
+	 * @retval	Number of valid readings young enough
+	 */
+	static size_t GetAll(SensorCache *const *ppCaches, size_t NumCaches, SensorReading *pReadings,
+			uint32_t MaxAgeMs);
+
+private:
+	Sensor *const m_pSensor;
+};
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Registers the "sensor" command, before Command_Init
+ */
+void SensorCache_Init(void);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* INC_SENSOR_CACHE_H_ */
@@ -2,27 +2,144 @@
 #include "app.h"
 
 #include "logger.h"
+#include "command.h"
+#include "journal.h"
+#include "sensor_cache.h"
+#include "bench.h"
 
-#include "dht11.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "dht.h"
+#include "edge_capture.h"
+#include "ds18b20.h"
+#include "sht3x.h"
+#include "adc_scan.h"
+#include "ntc.h"
+
+// First test sensor on PA0 timed by TIM2 channel 1 capture, or on PC0 timed by its
+// EXTI interrupt. The second is on PC1, read in the same round.
+#define TEST_SENSOR_CAPTURE		true
+
+// DS18B20 probes on the USART2 1-Wire bus, PA2 with a 4.7k pull-up
+#define TEST_ONE_WIRE			true
+
+// SHT3x on the I2C1 sensor bus, remapped to PB8/PB9
+#define TEST_SHT3X				true
+
+// NTC probes on ADC1 channels 1, 4, 8 and 9, PA1, PA4, PB0 and PB1, each under a 10k pull-up
+#define TEST_NTC				true
 
 osThreadId_t TestThreadHandle;
 
+static constexpr LoggerModule s_TestModule(LogModuleId::Test);
+
+// Readings are journaled at most this often to spare the flash
+static constexpr uint32_t s_SnapshotPeriodMs = 60000;
+
+// Oldest reading the test task acts on
+static constexpr uint32_t s_ReadingMaxAgeMs = 2000;
+
 void Test_Task(void *pvParamaters)
 {
 	(void) pvParamaters;
 
-	static LoggerModule TestLoggerModule("Test");
 	static int Count = 0;
-	LOGGER.LogF(&TestLoggerModule, "Started test task");
+	LOG_INFO(&s_TestModule, "Started test task");
 
+#if TEST_SENSOR_CAPTURE
+	static EdgeCapture DHT11Capture(TIM2, DMA1_Channel5, DMA1_Channel5_IRQn);
+	DHT11Capture.Init();
+	static DHT11 DHT11Test(GPIOA, 0, &DHT11Capture);
+#else
 	static DHT11 DHT11Test(GPIOC, 0, EXTI0_IRQn);
-	static uint8_t DHT11RxBuff[6] = {0};
+#endif
+	static DHT11 DHT11Second(GPIOC, 1, EXTI1_IRQn);
+
+	// Every consumer goes through the caches, the sensors are never read twice as often
+	static SensorCache<DHT11> TestCache(&DHT11Test);
+	static SensorCache<DHT11> SecondCache(&DHT11Second);
+
+	static SensorCache<DHT11> *const pCaches[] = { &TestCache, &SecondCache };
+	static constexpr size_t NumSensors = sizeof(pCaches) / sizeof(pCaches[0]);
+	SensorReading Readings[NumSensors];
+
+#if TEST_ONE_WIRE
+	static OneWire ProbeBus(USART2, DMA1_Channel7, DMA1_Channel6, DMA1_Channel6_IRQn, GPIOA, 2);
+	ProbeBus.Init();
+	static DS18B20 Probes(&ProbeBus);
+	Probes.Discover();
+
+	int16_t ProbeTemperatures[DS18B20::s_MaxProbes];
+	bool ProbeValid[DS18B20::s_MaxProbes];
+#endif
+
+#if TEST_SHT3X
+	static I2cMaster SensorBus(I2C1, I2C1_EV_IRQn, I2C1_ER_IRQn, GPIOB, 8, 9);
+	SensorBus.Init();
+	static SHT3x Sht(&SensorBus, 0x44);
+	Sht.Start();
+#endif
+
+#if TEST_NTC
+	static const uint8_t NtcChannels[] = { 1, 4, 8, 9 };
+	static constexpr size_t NumNtcs = sizeof(NtcChannels) / sizeof(NtcChannels[0]);
+	static AdcScan Thermistors(ADC1, DMA1_Channel1, DMA1_Channel1_IRQn, TIM3, NtcChannels, NumNtcs);
+	Thermistors.Init();
+	uint16_t NtcCodes[NumNtcs];
+#endif
+
+	uint32_t LastSnapshotTick = osKernelGetTickCount() - pdMS_TO_TICKS(s_SnapshotPeriodMs);
 
 	while (1)
 	{
 		osDelay(1000);
-		LOGGER.LogF(&TestLoggerModule, "Kushal %d", Count++);
-		DHT11Test.ReadBlocking(DHT11RxBuff);
+		LOG_DEBUG(&s_TestModule, "Kushal %d", Count++);
+		SensorCache<DHT11>::GetAll(pCaches, NumSensors, Readings, s_ReadingMaxAgeMs);
+
+#if TEST_ONE_WIRE
+		Probes.ReadAll(ProbeTemperatures, ProbeValid);
+#endif
+
+#if TEST_SHT3X
+		int16_t ShtTemperature;
+		uint16_t ShtHumidity;
+
+		if (Sht.GetLatest(&ShtTemperature, &ShtHumidity, nullptr))
+		{
+			LOG_DEBUG(&s_TestModule, "SHT3x %d tenths C %d tenths %%RH", ShtTemperature, ShtHumidity);
+		}
+#endif
+
+#if TEST_NTC
+		if (Thermistors.GetCodes(NtcCodes))
+		{
+			for (size_t Idx = 0; Idx < NumNtcs; Idx++)
+			{
+				int16_t NtcTemperature;
+
+				if (Ntc_ToTenths(NtcCodes[Idx], &NtcTemperature))
+				{
+					LOG_DEBUG(&s_TestModule, "NTC %d %d tenths C", Idx, NtcTemperature);
+				}
+			}
+		}
+#endif
+
+		if ((osKernelGetTickCount() - LastSnapshotTick) >= pdMS_TO_TICKS(s_SnapshotPeriodMs))
+		{
+			for (size_t Idx = 0; Idx < NumSensors; Idx++)
+			{
+				const Journal_SnapshotData Snapshot = { (uint8_t)Idx, Readings[Idx].Valid,
+						(int8_t)(Readings[Idx].Temperature / 10), (uint8_t)(Readings[Idx].Humidity / 10) };
+				Journal_Append(Journal_Snapshot, &Snapshot, sizeof(Snapshot));
+			}
+
+			LastSnapshotTick = osKernelGetTickCount();
+
+			// Least stack left so far, TaskStack is sized from this
+			LOG_INFO(&s_TestModule, "Stack %lu words free", (unsigned long)uxTaskGetStackHighWaterMark(nullptr));
+		}
 	}
 }
 
@@ -30,11 +147,24 @@ extern "C" {
 void App_Init(void)
 {
 	Logger_Init();
+	Journal_Init();
+	SensorCache_Init();
+	Bench_Init();
+	Command_Init();
+	DHT11_Init();
+
+	// Heap is too small to spare for another task, allocate statically. The sensor
+	// drivers and formatted logs outgrew 128 words, size from the logged high water mark.
+	static StaticTask_t TaskControlBlock;
+	static uint32_t TaskStack[256];
 
 	const osThreadAttr_t TaskAttributes =
 	{
 		.name = "Test_Task",
-		.stack_size = 128 * 4,
+		.cb_mem = &TaskControlBlock,
+		.cb_size = sizeof(TaskControlBlock),
+		.stack_mem = TaskStack,
+		.stack_size = sizeof(TaskStack),
 		.priority = (osPriority_t) osPriorityNormal,
 	};
 
@@ -0,0 +1,212 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "logger.h"
+#include "command.h"
+#include "format.h"
+#include "timebase.h"
+
+#include "stm32f1xx_hal.h"
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Also times newlib's snprintf in "bench format". Off by default, it links the printf
+// core the logger's own formatter keeps out of the image.
+//#define BENCH_SNPRINTF
+
+#if defined(BENCH_SNPRINTF)
+#include <stdio.h>
+#endif
+
+static constexpr LoggerModule s_BenchModule(LogModuleId::Bench);
+
+// Runs of each benchmark, the fastest is the cost without interference
+static constexpr size_t s_Runs = 64;
+
+// Free stack left untouched either side of the painted region
+static constexpr size_t s_StackGuardWords = 16;
+static constexpr uint32_t s_StackPaint = 0x5A5A5A5A;
+
+/**
+ * @brief	Cycle counts of a benchmark's runs
+ */
+struct BenchResult
+{
+	uint32_t Min;
+	uint32_t Max;
+	uint32_t Mean;
+	size_t StackBytes;
+};
+
+/**
+ * @brief	Measures the deepest stack a function uses
+ * @note	Interrupts stack their frames on the main stack, but their entry also
+ * 			pushes onto the task's stack, so they are disabled while it runs. The
+ * 			free part of the task's stack below the stack pointer is painted and the
+ * 			deepest word changed is found afterwards.
+ */
+static size_t MeasureStack(void (*Function)(void))
+{
+	size_t FreeWords = uxTaskGetStackHighWaterMark(nullptr);
+
+	if (FreeWords <= (2 * s_StackGuardWords))
+	{
+		return 0;
+	}
+
+	volatile uint32_t *pTop = (volatile uint32_t *)__get_PSP() - s_StackGuardWords;
+	volatile uint32_t *pBottom = pTop - (FreeWords - (2 * s_StackGuardWords));
+
+	uint32_t Primask = __get_PRIMASK();
+	__disable_irq();
+
+	for (volatile uint32_t *pWord = pBottom; pWord < pTop; pWord++)
+	{
+		*pWord = s_StackPaint;
+	}
+
+	Function();
+
+	__set_PRIMASK(Primask);
+
+	volatile uint32_t *pWord = pBottom;
+
+	while ((pWord < pTop) && (*pWord == s_StackPaint))
+	{
+		pWord++;
+	}
+
+	return (pWord < pTop) ? (size_t)((uintptr_t)(pTop + s_StackGuardWords) - (uintptr_t)pWord) : 0;
+}
+
+/**
+ * @brief	Times a function over s_Runs runs and measures its stack
+ * @param	NumCalls	Calls each run makes, the cycles are per call
+ */
+static BenchResult Measure(void (*Function)(void), uint32_t NumCalls)
+{
+	BenchResult Result = { UINT32_MAX, 0, 0, 0 };
+	uint64_t Total = 0;
+
+	// No task switches, interrupts still count towards the maximum
+	osKernelLock();
+
+	for (size_t Run = 0; Run < s_Runs; Run++)
+	{
+		uint64_t Start = Timebase_GetCycles();
+		Function();
+		uint32_t Cycles = (uint32_t)(Timebase_GetCycles() - Start) / NumCalls;
+
+		Result.Min = (Cycles < Result.Min) ? Cycles : Result.Min;
+		Result.Max = (Cycles > Result.Max) ? Cycles : Result.Max;
+		Total += Cycles;
+	}
+
+	osKernelUnlock();
+
+	Result.Mean = (uint32_t)(Total / s_Runs);
+	Result.StackBytes = MeasureStack(Function);
+
+	return Result;
+}
+
+/**
+ * @brief	Logs a benchmark's result
+ */
+static void Report(const char *pName, const BenchResult &Result)
+{
+	LOG_INFO(&s_BenchModule, "%s %lu min %lu mean %lu max cycles, %d bytes stack", pName, Result.Min, Result.Mean,
+			Result.Max, Result.StackBytes);
+}
+
+// Formatting benchmark output, static so it isn't counted as the formatter's stack
+static char s_FormatBuffer[128];
+
+// Calls made by each formatting run, the kind of messages the logger formats
+static constexpr uint32_t s_FormatCalls = 3;
+
+static void FormatRun(void)
+{
+	Format_Print(s_FormatBuffer, sizeof(s_FormatBuffer), "%d %s%lu.%luC %d.%d%%RH, %lums old", 1, "-", 12UL, 5UL,
+			48, 2, 1500UL);
+	Format_Print(s_FormatBuffer, sizeof(s_FormatBuffer), "ROM %08lx%08lx%s", 0x28FF1234UL, 0x56789ABCUL, " DS18B20");
+	Format_Print(s_FormatBuffer, sizeof(s_FormatBuffer), "%02x Timed out after %d bytes, SR1 %04lx SR2 %04lx", 0x44,
+			3, 0x0400UL, 0x0003UL);
+}
+
+#if defined(BENCH_SNPRINTF)
+static void SnprintfRun(void)
+{
+	snprintf(s_FormatBuffer, sizeof(s_FormatBuffer), "%d %s%lu.%luC %d.%d%%RH, %lums old", 1, "-", 12UL, 5UL, 48,
+			2, 1500UL);
+	snprintf(s_FormatBuffer, sizeof(s_FormatBuffer), "ROM %08lx%08lx%s", 0x28FF1234UL, 0x56789ABCUL, " DS18B20");
+	snprintf(s_FormatBuffer, sizeof(s_FormatBuffer), "%02x Timed out after %d bytes, SR1 %04lx SR2 %04lx", 0x44, 3,
+			0x0400UL, 0x0003UL);
+}
+#endif
+
+/**
+ * @brief	Times Format_Print, against the C library's snprintf with BENCH_SNPRINTF
+ */
+static void BenchFormat(void)
+{
+	Report("Format_Print", Measure(FormatRun, s_FormatCalls));
+#if defined(BENCH_SNPRINTF)
+	Report("snprintf", Measure(SnprintfRun, s_FormatCalls));
+#endif
+}
+
+/**
+ * @brief	Times interrupt logging, uncontended and in the worst case
+ */
+static void BenchLog(void)
+{
+	uint32_t Fastest;
+	uint32_t Slowest;
+
+	LOGGER.BenchmarkFromISR(false, s_Runs, &Fastest, &Slowest);
+	LOG_INFO(&s_BenchModule, "LogFromISR uncontended %lu min %lu max cycles", Fastest, Slowest);
+
+	LOGGER.BenchmarkFromISR(true, s_Runs, &Fastest, &Slowest);
+	LOG_INFO(&s_BenchModule, "LogFromISR contended %lu min %lu max cycles", Fastest, Slowest);
+}
+
+/**
+ * @brief	Runs a benchmark
+ */
+static void BenchCommand(int Argc, char *pArgv[])
+{
+	if ((Argc == 2) && (strcmp(pArgv[1], "format") == 0))
+	{
+		BenchFormat();
+		return;
+	}
+
+	if ((Argc == 2) && (strcmp(pArgv[1], "log") == 0))
+	{
+		BenchLog();
+		return;
+	}
+
+	LOG_WARN(&s_BenchModule, "Usage: bench format | bench log");
+}
+
+extern "C" {
+
+void Bench_Init(void)
+{
+	Command_Register("bench", BenchCommand, "bench format | bench log");
+}
+
+}
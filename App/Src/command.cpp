@@ -0,0 +1,199 @@
+/*
+ * command.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "command.h"
+
+#include <string.h>
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "stream_buffer.h"
+
+#include "stm32f1xx_hal.h"
+#include "stm32f1xx_hal_uart.h"
+
+#include "logger.h"
+
+extern UART_HandleTypeDef huart1;
+
+static constexpr LoggerModule s_CommandModule(LogModuleId::Command);
+
+// Registered commands
+struct CommandEntry
+{
+	const char *pName;
+	Command_Handler Handler;
+	const char *pUsage;
+};
+
+static constexpr size_t s_MaxCommands = 8;
+static CommandEntry s_Commands[s_MaxCommands];
+static size_t s_NumCommands = 0;
+
+// Received bytes, written from interrupts and read by the command task
+static constexpr size_t s_RxBufferSize = 64;
+static uint8_t s_RxStorage[s_RxBufferSize + 1];
+static StaticStreamBuffer_t s_RxStreamBuffer;
+static StreamBufferHandle_t s_RxStream = nullptr;
+
+// USART1 receives a byte at a time
+static uint8_t s_RxByte;
+
+// Longest line and most words on it
+static constexpr size_t s_MaxLineLength = 64;
+static constexpr size_t s_MaxArguments = 6;
+
+bool Command_Register(const char *Name, Command_Handler Handler, const char *Usage)
+{
+	if (s_NumCommands >= s_MaxCommands)
+	{
+		return false;
+	}
+
+	s_Commands[s_NumCommands++] = { Name, Handler, Usage };
+	return true;
+}
+
+void Command_ReceiveFromISR(const uint8_t *pData, size_t Length)
+{
+	if (s_RxStream == nullptr)
+	{
+		return;
+	}
+
+	// Bytes that don't fit are lost, the line is rejected as garbage if they mattered
+	BaseType_t Woken = pdFALSE;
+	xStreamBufferSendFromISR(s_RxStream, pData, Length, &Woken);
+	portYIELD_FROM_ISR(Woken);
+}
+
+void Command_ReceiveCompleteInterruptCallback(void)
+{
+	Command_ReceiveFromISR(&s_RxByte, 1);
+	HAL_UART_Receive_IT(&huart1, &s_RxByte, 1);
+}
+
+void Command_ErrorInterruptCallback(void)
+{
+	// The HAL has cleared the error. The byte is dropped, a line it was part of is
+	// rejected as garbage. Busy if reception survived a noise or framing error.
+	HAL_UART_Receive_IT(&huart1, &s_RxByte, 1);
+}
+
+/**
+ * @brief	Lists registered commands
+ */
+static void HelpCommand(int Argc, char *pArgv[])
+{
+	(void) Argc;
+	(void) pArgv;
+
+	for (size_t Idx = 0; Idx < s_NumCommands; Idx++)
+	{
+		LOG_INFO(&s_CommandModule, "%s", s_Commands[Idx].pUsage);
+	}
+}
+
+/**
+ * @brief	Splits a line into words and runs the matching command
+ */
+static void Execute(char *pLine)
+{
+	char *pArgv[s_MaxArguments] = { nullptr };
+	int Argc = 0;
+	char *pSave = nullptr;
+
+	for (char *pWord = strtok_r(pLine, " \t", &pSave);
+		(pWord != nullptr) && (Argc < (int)s_MaxArguments);
+		pWord = strtok_r(nullptr, " \t", &pSave))
+	{
+		pArgv[Argc++] = pWord;
+	}
+
+	if (Argc == 0)
+	{
+		return;
+	}
+
+	for (size_t Idx = 0; Idx < s_NumCommands; Idx++)
+	{
+		if (strcmp(pArgv[0], s_Commands[Idx].pName) == 0)
+		{
+			s_Commands[Idx].Handler(Argc, pArgv);
+			return;
+		}
+	}
+
+	LOG_WARN(&s_CommandModule, "Unknown command, try help");
+}
+
+void Command_Task(void *pvParameters)
+{
+	(void) pvParameters;
+
+	char Line[s_MaxLineLength + 1];
+	size_t LineLength = 0;
+	bool Overflow = false;
+
+	while (1)
+	{
+		uint8_t Byte;
+
+		if (xStreamBufferReceive(s_RxStream, &Byte, 1, portMAX_DELAY) == 0)
+		{
+			continue;
+		}
+
+		if ((Byte == '\r') || (Byte == '\n'))
+		{
+			if (Overflow)
+			{
+				LOG_WARN(&s_CommandModule, "Line too long");
+			}
+			else
+			{
+				Line[LineLength] = 0;
+				Execute(Line);
+			}
+
+			LineLength = 0;
+			Overflow = false;
+		}
+		else if (LineLength < s_MaxLineLength)
+		{
+			Line[LineLength++] = (char)Byte;
+		}
+		else
+		{
+			Overflow = true;
+		}
+	}
+}
+
+void Command_Init(void)
+{
+	// Heap is too small to spare for another task, allocate statically
+	static StaticTask_t TaskControlBlock;
+	static uint32_t TaskStack[256];
+
+	const osThreadAttr_t TaskAttributes = {
+		.name = "Command_Task",
+		.cb_mem = &TaskControlBlock,
+		.cb_size = sizeof(TaskControlBlock),
+		.stack_mem = TaskStack,
+		.stack_size = sizeof(TaskStack),
+		.priority = (osPriority_t) osPriorityBelowNormal,
+	};
+
+	Command_Register("help", HelpCommand, "help");
+
+	s_RxStream = xStreamBufferCreateStatic(s_RxBufferSize, 1, s_RxStorage, &s_RxStreamBuffer);
+	osThreadNew(Command_Task, nullptr, &TaskAttributes);
+
+	HAL_UART_Receive_IT(&huart1, &s_RxByte, 1);
+}
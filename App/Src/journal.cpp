@@ -0,0 +1,532 @@
+/*
+ * journal.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "journal.h"
+
+#include <string.h>
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stm32f1xx_hal.h"
+
+#include "command.h"
+#include "logger.h"
+
+#include "dht.h"
+
+// Dumps wait for the logger rather than lose lines
+static constexpr LoggerModule s_JournalModule(LogModuleId::Journal, LogPolicy::Block, 100);
+
+// Top pages of the 128 KB flash, the linker script keeps the program out of them.
+// Pages are written round robin, so each is erased once per s_NumPages pages of entries.
+// The page after the active one is erased ahead of time, so s_NumPages - 1 hold entries.
+static constexpr uint32_t s_NumPages = 4;
+static constexpr uint32_t s_PageSize = FLASH_PAGE_SIZE;
+static constexpr uint32_t s_FirstPageAddress = FLASH_BASE + (128 * 1024) - (s_NumPages * s_PageSize);
+
+static constexpr uint16_t s_PageMagic = 0x4A4C;
+static constexpr uint16_t s_Erased = 0xFFFF;
+
+/**
+ * @brief	Start of every journal page
+ * @note	The magic is programmed last, a page with a torn header is never used
+ */
+struct PageHeader
+{
+	uint16_t Magic;
+	uint16_t Reserved;
+	uint32_t Sequence;	// Increments with every page started, the highest is being written
+};
+
+/**
+ * @brief	Start of every entry, the payload follows padded to a half-word
+ * @note	The first half-word is programmed last, an entry torn by a reset is never seen
+ */
+struct EntryHeader
+{
+	uint8_t Type;
+	uint8_t Length;		// Payload bytes
+	uint16_t Boot;		// Boots since the journal was created
+	uint32_t TimeMs;	// Since boot
+};
+
+static_assert(((sizeof(PageHeader) % sizeof(uint16_t)) == 0) && ((sizeof(EntryHeader) % sizeof(uint16_t)) == 0),
+		"Journal headers must be programmable in half-words");
+
+// Entries wait in RAM and are written a batch at a time by the journal task, one batch
+// fills while the other is written
+static constexpr size_t s_BatchSize = 256;
+static constexpr uint32_t s_FlushPeriodMs = 10000;
+
+alignas(uint16_t) static uint8_t s_Batches[2][s_BatchSize];
+static size_t s_BatchLengths[2] = { 0 };
+static size_t s_FillingBatch = 0;
+static uint32_t s_Dropped = 0;
+
+// Where the next entry goes
+static uint32_t s_ActivePage = s_NumPages - 1;
+static uint32_t s_Sequence = 0;
+static uint32_t s_WriteOffset = s_PageSize;
+static uint16_t s_Boot = 0;
+
+// The page after the active one is erased and ready to start
+static bool s_NextPageErased = false;
+
+static osThreadId_t s_TaskHandle = nullptr;
+
+/**
+ * @brief	Rounds a length up to a whole number of half-words
+ */
+static constexpr size_t AlignToHalfWord(size_t Length)
+{
+	return (Length + 1) & ~(size_t)1;
+}
+
+/**
+ * @brief	Gets a journal page by index
+ */
+static const PageHeader *GetPage(uint32_t Page)
+{
+	return (const PageHeader *)(uintptr_t)(s_FirstPageAddress + (Page * s_PageSize));
+}
+
+/**
+ * @brief	Checks every word of a page reads as erased
+ */
+static bool IsErased(uint32_t Page)
+{
+	const uint32_t *pWords = (const uint32_t *)GetPage(Page);
+
+	for (size_t Idx = 0; Idx < (s_PageSize / sizeof(uint32_t)); Idx++)
+	{
+		if (pWords[Idx] != UINT32_MAX)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Walks the entries of a page in order
+ * @param	Visit	Called for each entry, may be nullptr
+ * @retval	Offset of the first free half-word, s_PageSize if nothing more can be appended
+ */
+static uint32_t WalkPage(uint32_t Page, void (*Visit)(const EntryHeader *pEntry))
+{
+	const uint8_t *pPage = (const uint8_t *)GetPage(Page);
+	uint32_t Offset = sizeof(PageHeader);
+
+	while ((Offset + sizeof(EntryHeader)) <= s_PageSize)
+	{
+		const EntryHeader *pEntry = (const EntryHeader *)&pPage[Offset];
+
+		if (*(const uint16_t *)pEntry == s_Erased)
+		{
+			break;
+		}
+
+		uint32_t Size = sizeof(EntryHeader) + AlignToHalfWord(pEntry->Length);
+
+		if ((Offset + Size) > s_PageSize)
+		{
+			return s_PageSize;
+		}
+
+		if (Visit != nullptr)
+		{
+			Visit(pEntry);
+		}
+
+		Offset += Size;
+	}
+
+	// Anything programmed past the last entry was torn by a reset, half-words can't be
+	// programmed twice so the page is done
+	for (uint32_t Idx = Offset; Idx < s_PageSize; Idx += sizeof(uint16_t))
+	{
+		if (*(const uint16_t *)&pPage[Idx] != s_Erased)
+		{
+			return s_PageSize;
+		}
+	}
+
+	return Offset;
+}
+
+/**
+ * @brief	Programs half-words, flash must be unlocked
+ * @retval	false	A half-word failed to program
+ */
+static bool Program(uint32_t Address, const uint8_t *pData, size_t Length)
+{
+	for (size_t Idx = 0; Idx < Length; Idx += sizeof(uint16_t))
+	{
+		uint16_t HalfWord;
+		memcpy(&HalfWord, &pData[Idx], sizeof(HalfWord));
+
+		if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, Address + Idx, HalfWord) != HAL_OK)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	Erases a page, flash must be unlocked
+ * @retval	false	Erase failed
+ */
+static bool ErasePage(uint32_t Page)
+{
+	FLASH_EraseInitTypeDef Erase = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.Banks = FLASH_BANK_1,
+		.PageAddress = (uint32_t)(uintptr_t)GetPage(Page),
+		.NbPages = 1,
+	};
+
+	uint32_t PageError = 0;
+
+	return (HAL_FLASHEx_Erase(&Erase, &PageError) == HAL_OK);
+}
+
+/**
+ * @brief	Makes the next page round robin the active one, erasing it if it wasn't
+ * 			erased ahead of time
+ * @retval	false	Erase or header programming failed
+ */
+static bool StartNextPage(void)
+{
+	uint32_t Page = (s_ActivePage + 1) % s_NumPages;
+	uint32_t Address = (uint32_t)(uintptr_t)GetPage(Page);
+	PageHeader Header = { s_PageMagic, s_Erased, s_Sequence + 1 };
+	bool Erased = s_NextPageErased;
+
+	// Page is unusable until a later erase succeeds, keep trying the next one
+	s_ActivePage = Page;
+	s_WriteOffset = s_PageSize;
+	s_NextPageErased = false;
+
+	if ((!Erased && !ErasePage(Page)) ||
+		!Program(Address + offsetof(PageHeader, Sequence), (const uint8_t *)&Header.Sequence, sizeof(Header.Sequence)) ||
+		!Program(Address, (const uint8_t *)&Header.Magic, sizeof(Header.Magic)))
+	{
+		return false;
+	}
+
+	s_Sequence = Header.Sequence;
+	s_WriteOffset = sizeof(PageHeader);
+
+	return true;
+}
+
+/**
+ * @brief	Programs one entry, starting a new page if it doesn't fit
+ * @retval	false	Flash failed, the entry is lost
+ */
+static bool WriteEntry(const uint8_t *pEntry, size_t Size)
+{
+	if (((s_WriteOffset + Size) > s_PageSize) && !StartNextPage())
+	{
+		return false;
+	}
+
+	uint32_t Address = (uint32_t)(uintptr_t)GetPage(s_ActivePage) + s_WriteOffset;
+
+	// First half-word commits the entry
+	bool Written = Program(Address + sizeof(uint16_t), &pEntry[sizeof(uint16_t)], Size - sizeof(uint16_t)) &&
+			Program(Address, pEntry, sizeof(uint16_t));
+
+	// Half-programmed space can't be reused, move on to a fresh page with the next entry
+	s_WriteOffset = Written ? (s_WriteOffset + Size) : s_PageSize;
+
+	return Written;
+}
+
+bool Journal_Append(Journal_EntryType Type, const void *pData, size_t Length)
+{
+	size_t Size = sizeof(EntryHeader) + AlignToHalfWord(Length);
+
+	if ((s_TaskHandle == nullptr) || (Size > s_BatchSize))
+	{
+		return false;
+	}
+
+	const EntryHeader Header = { (uint8_t)Type, (uint8_t)Length, s_Boot, HAL_GetTick() };
+	bool Queued = false;
+
+	osKernelLock();
+
+	uint8_t *pBatch = s_Batches[s_FillingBatch];
+	size_t BatchLength = s_BatchLengths[s_FillingBatch];
+
+	if ((BatchLength + Size) <= s_BatchSize)
+	{
+		memcpy(&pBatch[BatchLength], &Header, sizeof(Header));
+		memcpy(&pBatch[BatchLength + sizeof(Header)], pData, Length);
+
+		// Odd payloads are padded with what erased flash reads as
+		if (Length % sizeof(uint16_t))
+		{
+			pBatch[BatchLength + Size - 1] = 0xFF;
+		}
+
+		BatchLength += Size;
+		s_BatchLengths[s_FillingBatch] = BatchLength;
+		Queued = true;
+	}
+	else
+	{
+		s_Dropped++;
+	}
+
+	osKernelUnlock();
+
+	if (BatchLength >= (s_BatchSize / 2))
+	{
+		xTaskNotifyGive((TaskHandle_t)s_TaskHandle);
+	}
+
+	return Queued;
+}
+
+/**
+ * @brief	Waits until no DHT round is in flight and holds the next one off
+ * @note	Rounds take ~30 ms, polled every tick like a round waiting on a channel
+ */
+static void ClaimFlash(void)
+{
+	while (!DHT_ClaimFlash())
+	{
+		osDelay(1);
+	}
+}
+
+void Journal_Task(void *pvParameters)
+{
+	(void) pvParameters;
+
+	while (1)
+	{
+		// Batches go out every flush period, or sooner once half full
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(s_FlushPeriodMs));
+
+		osKernelLock();
+		size_t Batch = s_FillingBatch;
+		s_FillingBatch ^= 1;
+		osKernelUnlock();
+
+		const uint8_t *pBatch = s_Batches[Batch];
+		size_t Length = s_BatchLengths[Batch];
+		uint32_t Failed = 0;
+
+		// Programming stalls every fetch from flash, interrupts included, for ~50 us a
+		// half-word, and an erase for ~20 ms. Running at low priority doesn't keep that
+		// off the interrupts, so each entry and erase waits for the DHT sensors to be
+		// between rounds, whose edge timestamps a stall would throw out.
+		HAL_FLASH_Unlock();
+
+		for (size_t Offset = 0; Offset < Length; )
+		{
+			const EntryHeader *pEntry = (const EntryHeader *)&pBatch[Offset];
+			size_t Size = sizeof(EntryHeader) + AlignToHalfWord(pEntry->Length);
+
+			ClaimFlash();
+			Failed += WriteEntry(&pBatch[Offset], Size) ? 0 : 1;
+			DHT_ReleaseFlash();
+
+			Offset += Size;
+		}
+
+		// Erase the next page now rather than when an entry needs it
+		if (!s_NextPageErased)
+		{
+			uint32_t Page = (s_ActivePage + 1) % s_NumPages;
+
+			ClaimFlash();
+			s_NextPageErased = ErasePage(Page);
+			DHT_ReleaseFlash();
+		}
+
+		HAL_FLASH_Lock();
+
+		s_BatchLengths[Batch] = 0;
+
+		if (Failed > 0)
+		{
+			LOG_WARN(&s_JournalModule, "%lu entries failed to program", Failed);
+		}
+	}
+}
+
+/**
+ * @brief	Logs one journal entry
+ */
+static void DumpEntry(const EntryHeader *pEntry)
+{
+	const uint8_t *pPayload = (const uint8_t *)(pEntry + 1);
+	unsigned Boot = pEntry->Boot;
+	unsigned long Seconds = pEntry->TimeMs / 1000;
+	unsigned long Milliseconds = pEntry->TimeMs % 1000;
+
+	switch (pEntry->Type)
+	{
+	case Journal_Boot:
+	{
+		uint32_t Flags = 0;
+		memcpy(&Flags, pPayload, (pEntry->Length < sizeof(Flags)) ? pEntry->Length : sizeof(Flags));
+		LOG_INFO(&s_JournalModule, "#%u boot, reset flags %08lx", Boot, Flags);
+		break;
+	}
+
+	case Journal_Snapshot:
+	{
+		Journal_SnapshotData Snapshot = { 0 };
+		memcpy(&Snapshot, pPayload, (pEntry->Length < sizeof(Snapshot)) ? pEntry->Length : sizeof(Snapshot));
+		LOG_INFO(&s_JournalModule, "#%u %5lu.%03lu sensor %u %d C %u %%%s", Boot, Seconds, Milliseconds,
+				Snapshot.Sensor, Snapshot.Temperature, Snapshot.Humidity, Snapshot.Valid ? "" : " invalid");
+		break;
+	}
+
+	case Journal_Log:
+	{
+#if defined(LOG_BINARY)
+		// Frames go out as hex, eight bytes a line
+		LOG_INFO(&s_JournalModule, "#%u %5lu.%03lu frame of %u bytes", Boot, Seconds, Milliseconds, pEntry->Length);
+
+		for (size_t Idx = 0; Idx < pEntry->Length; Idx += 8)
+		{
+			uint8_t Bytes[8] = { 0 };
+			memcpy(Bytes, &pPayload[Idx], ((pEntry->Length - Idx) < sizeof(Bytes)) ? (pEntry->Length - Idx) : sizeof(Bytes));
+			LOG_INFO(&s_JournalModule, "%02x %02x %02x %02x %02x %02x %02x %02x", Bytes[0], Bytes[1], Bytes[2], Bytes[3],
+					Bytes[4], Bytes[5], Bytes[6], Bytes[7]);
+		}
+#else
+		// Records carry their own timestamp, drop the line ending they were rendered with
+		int Length = pEntry->Length;
+
+		while ((Length > 0) && ((pPayload[Length - 1] == '\r') || (pPayload[Length - 1] == '\n')))
+		{
+			Length--;
+		}
+
+		LOG_INFO(&s_JournalModule, "#%u %.*s", Boot, Length, (const char *)pPayload);
+#endif
+		break;
+	}
+
+	default:
+		LOG_INFO(&s_JournalModule, "#%u %5lu.%03lu unknown entry type %u", Boot, Seconds, Milliseconds, pEntry->Type);
+		break;
+	}
+}
+
+/**
+ * @brief	"journal" command, dumps the journal oldest first or shows where it is
+ * @note	Entries written while dumping may be missed
+ */
+static void JournalCommand(int Argc, char *pArgv[])
+{
+	if ((Argc == 2) && (strcmp(pArgv[1], "dump") == 0))
+	{
+		// Pages are used round robin, the oldest follows the active one
+		for (uint32_t Idx = 1; Idx <= s_NumPages; Idx++)
+		{
+			uint32_t Page = (s_ActivePage + Idx) % s_NumPages;
+
+			if (GetPage(Page)->Magic == s_PageMagic)
+			{
+				WalkPage(Page, DumpEntry);
+			}
+		}
+	}
+	else if ((Argc == 2) && (strcmp(pArgv[1], "status") == 0))
+	{
+		LOG_INFO(&s_JournalModule, "boot %u page %lu sequence %lu offset %lu, %lu entries dropped", s_Boot,
+				s_ActivePage, s_Sequence, s_WriteOffset, s_Dropped);
+	}
+	else
+	{
+		LOG_WARN(&s_JournalModule, "Usage: journal dump | journal status");
+	}
+}
+
+static uint16_t s_LastBoot = 0;
+
+/**
+ * @brief	Finds the latest boot number in the journal
+ */
+static void FindLastBoot(const EntryHeader *pEntry)
+{
+	if (pEntry->Boot > s_LastBoot)
+	{
+		s_LastBoot = pEntry->Boot;
+	}
+}
+
+void Journal_Init(void)
+{
+	// Heap is too small to spare for another task, allocate statically
+	static StaticTask_t TaskControlBlock;
+	static uint32_t TaskStack[128];
+
+	const osThreadAttr_t TaskAttributes = {
+		.name = "Journal_Task",
+		.cb_mem = &TaskControlBlock,
+		.cb_size = sizeof(TaskControlBlock),
+		.stack_mem = TaskStack,
+		.stack_size = sizeof(TaskStack),
+		.priority = (osPriority_t) osPriorityLow,
+	};
+
+	// Carry on in the page with the highest sequence, a blank journal starts at page 0
+	bool Found = false;
+
+	for (uint32_t Page = 0; Page < s_NumPages; Page++)
+	{
+		const PageHeader *pPage = GetPage(Page);
+
+		if (pPage->Magic != s_PageMagic)
+		{
+			continue;
+		}
+
+		WalkPage(Page, FindLastBoot);
+
+		if (!Found || ((int32_t)(pPage->Sequence - s_Sequence) > 0))
+		{
+			s_ActivePage = Page;
+			s_Sequence = pPage->Sequence;
+			Found = true;
+		}
+	}
+
+	if (Found)
+	{
+		s_WriteOffset = WalkPage(s_ActivePage, nullptr);
+	}
+
+	s_NextPageErased = IsErased((s_ActivePage + 1) % s_NumPages);
+
+	s_Boot = s_LastBoot + 1;
+
+	Command_Register("journal", JournalCommand, "journal dump | journal status");
+
+	s_TaskHandle = osThreadNew(Journal_Task, nullptr, &TaskAttributes);
+
+	// Every boot starts with why the last one ended
+	uint32_t ResetFlags = RCC->CSR;
+	RCC->CSR |= RCC_CSR_RMVF;
+
+	Journal_Append(Journal_Boot, &ResetFlags, sizeof(ResetFlags));
+}
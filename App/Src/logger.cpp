@@ -9,104 +9,1209 @@
 
 #include <string.h>
 #include <stdarg.h>
-#include <stdio.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "command.h"
+#include "crc.h"
+#include "format.h"
+#include "journal.h"
+
 extern UART_HandleTypeDef huart1;
 
-LoggerModule::LoggerModule(const char * ModuleName)
+// Top of RAM, from the linker script
+extern "C" uint32_t _estack;
+
+/**
+ * @brief	Atomically replaces *pValue with Desired if it still holds Expected
+ * @retval	true	Swap succeeded
+ */
+static inline bool CompareAndSwap(volatile uint32_t *pValue, uint32_t Expected, uint32_t Desired)
+{
+	if (__LDREXW(pValue) != Expected)
+	{
+		__CLREX();
+		return false;
+	}
+
+	return (__STREXW(Desired, pValue) == 0);
+}
+
+/**
+ * @brief	Atomically adds Delta to *pValue
+ */
+static inline void AtomicAdd(volatile uint32_t *pValue, uint32_t Delta)
+{
+	uint32_t Value;
+
+	do
+	{
+		Value = __LDREXW(pValue);
+	} while (__STREXW(Value + Delta, pValue) != 0);
+}
+
+// The logger's own module, used for counter summaries
+static constexpr LoggerModule s_LoggerModule(LogModuleId::Logger);
+
+// Fault and assert dumps, evicting older records rather than lose the dump
+static constexpr LoggerModule s_FaultModule(LogModuleId::Fault, LogPolicy::OverwriteOldest);
+
+// Names by module ID, the name and a colon make up the rendered prefix
+static constexpr const char *s_ModuleNames[] =
+{
+#define LOGGER_MODULE_NAME(Id, Name)	Name,
+	LOGGER_MODULES(LOGGER_MODULE_NAME)
+#undef LOGGER_MODULE_NAME
+};
+
+#define LOGGER_MODULE_NAME_CHECK(Id, Name)	\
+	static_assert(sizeof(Name) <= LoggerModule::s_MaxModuleNameLength, "Logger module name " Name " is too long");
+LOGGER_MODULES(LOGGER_MODULE_NAME_CHECK)
+#undef LOGGER_MODULE_NAME_CHECK
+
+// Every module starts at LogLevel::Trace, its compile-time floor does the filtering
+LoggerModule::State LoggerModule::s_States[(size_t)LogModuleId::Count] = {};
+
+const char * LoggerModule::GetModuleName(void) const
+{
+	return s_ModuleNames[(size_t)m_Id];
+}
+
+const char * LoggerModule::GetModuleName(LogModuleId Id)
+{
+	return ((size_t)Id < (size_t)LogModuleId::Count) ? s_ModuleNames[(size_t)Id] : "?";
+}
+
+LogPolicy LoggerModule::GetPolicy(void) const
+{
+	return m_Policy;
+}
+
+uint32_t LoggerModule::GetBlockTimeoutMs(void) const
+{
+	return m_BlockTimeoutMs;
+}
+
+void LoggerModule::SetLevel(LogLevel Level) const
+{
+	s_States[(size_t)m_Id].Level = Level;
+}
+
+LogLevel LoggerModule::GetLevel(void) const
+{
+	return s_States[(size_t)m_Id].Level;
+}
+
+void LoggerModule::CountLimited(void) const
+{
+	AtomicAdd(&s_States[(size_t)m_Id].Limited, 1);
+}
+
+bool LogRateLimiter::Allow(void)
+{
+	uint32_t Now = uwTick;
+	uint32_t Elapsed = Now - m_LastRefill;
+
+	if (m_Tokens >= m_Burst)
+	{
+		// Full bucket, the period starts with the next token spent
+		m_LastRefill = Now;
+	}
+	else if (Elapsed >= m_PeriodMs)
+	{
+		// Only divide once a token is due, and keep the remainder towards the next
+		uint32_t Earned = (m_PeriodMs > 0) ? (Elapsed / m_PeriodMs) : m_Burst;
+		uint32_t Tokens = m_Tokens + Earned;
+
+		m_Tokens = (Tokens < m_Burst) ? (uint16_t)Tokens : m_Burst;
+		m_LastRefill = (m_PeriodMs > 0) ? (m_LastRefill + (Earned * m_PeriodMs)) : Now;
+	}
+
+	if (m_Tokens == 0)
+	{
+		return false;
+	}
+
+	m_Tokens--;
+	return true;
+}
+
+Logger& Logger::Instance(void)
+{
+	// Not zeroed by the startup code, records logged before a fault survive the reset
+	__attribute__((section(".noinit"))) static Logger Instance;
+	return Instance;
+}
+
+Logger::Logger(void) :
+	m_Recovered(0),
+	m_Panicked(false),
+	m_TailLock(0),
+	m_SpaceWaiters(0),
+	m_LastSummaryTick(0),
+	m_SummaryTotals(),
+	m_IsrRings(),
+	m_LastTimestamp(0),
+	m_OutputHead(0),
+	m_FrameLength(0),
+	m_FrameOffset(0),
+	m_OutputStalled(false),
+	m_LastHash(0),
+	m_LastKey(UINT32_MAX),
+	m_LastLength(0),
+	m_LastPrefix(),
+	m_Repeats(0),
+	m_RepeatTimestamp(0),
+	m_RepeatTick(0),
+	m_RepeatModule(LogModuleId::Logger),
+	m_Sinks(),
+	m_NumSinks(0),
+	m_Idle(0)
+{
+	if (!Recover())
+	{
+		memset(m_Arena, 0, sizeof(m_Arena));
+		m_Head = 0;
+		m_Tail = 0;
+	}
+
+	// A seal is only good for one boot, a plain reset must not replay the same records
+	m_SealMagic = 0;
+}
+
+Logger::~Logger()
+{
+}
+
+/**
+ * @brief	Rounds a length up to a whole number of words
+ */
+static constexpr uint32_t AlignToWord(size_t Length)
+{
+	return (Length + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+Logger::Record *Logger::Reserve(size_t Length, RecordType Type)
+{
+	uint32_t Size = AlignToWord(Length);
+	uint32_t Head, Offset, Padding;
+
+	do
+	{
+		Head = __LDREXW(&m_Head);
+		Offset = Head % s_ArenaSize;
+
+		// Records never wrap, skip the end of the arena if this one won't fit
+		Padding = ((Offset + Size) > s_ArenaSize) ? (s_ArenaSize - Offset) : 0;
+
+		if ((Head + Padding + Size - m_Tail) > s_ArenaSize)
+		{
+			__CLREX();
+			return nullptr;
+		}
+	} while (__STREXW(Head + Padding + Size, &m_Head) != 0);
+
+	if (Padding > 0)
+	{
+		Record *pPadding = (Record *)&m_Arena[Offset];
+		pPadding->Header = Record::MakeHeader(Padding, RecordState::Padding, Type);
+		Offset = 0;
+	}
+
+	Record *pRecord = (Record *)&m_Arena[Offset];
+	pRecord->Header = Record::MakeHeader(Size, RecordState::Reserved, Type);
+
+	return pRecord;
+}
+
+bool Logger::TryLockTail(void)
+{
+	if (!CompareAndSwap(&m_TailLock, 0, 1))
+	{
+		return false;
+	}
+
+	__DMB();
+	return true;
+}
+
+void Logger::UnlockTail(void)
+{
+	__DMB();
+	m_TailLock = 0;
+}
+
+bool Logger::Evict(void)
+{
+	// The flusher may be copying the oldest record out, give up rather than wait
+	if (!TryLockTail())
+	{
+		return false;
+	}
+
+	Record *pRecord = Oldest();
+	uint32_t Header = pRecord->Header;
+	RecordState State = Record::GetState(Header);
+
+	// Records still being written can't be skipped, the arena is strictly ordered
+	bool Evicted = ((State == RecordState::Committed) || (State == RecordState::Padding));
+
+	if (Evicted)
+	{
+		if (State == RecordState::Committed)
+		{
+			AtomicAdd(&LoggerModule::s_States[(size_t)Record::GetModule(Header)].Dropped, 1);
+		}
+
+		Release(pRecord, Record::GetSize(Header));
+	}
+
+	UnlockTail();
+
+	return Evicted;
+}
+
+Logger::Record *Logger::WaitForSpace(size_t Length, RecordType Type, uint32_t TimeoutMs)
+{
+	// Interrupts can't block, and neither can the task that frees the space
+	if ((m_SpaceFlags == nullptr) || (__get_IPSR() != 0) ||
+		(osKernelGetState() != osKernelRunning) || (osThreadGetId() == m_TaskHandle))
+	{
+		return nullptr;
+	}
+
+	Record *pRecord = nullptr;
+	uint32_t Timeout = pdMS_TO_TICKS(TimeoutMs);
+	uint32_t Start = osKernelGetTickCount();
+
+	AtomicAdd(&m_SpaceWaiters, 1);
+
+	while (1)
+	{
+		// Clear before retrying so space freed after the attempt still wakes us
+		osEventFlagsClear(m_SpaceFlags, s_SpaceFreedFlag);
+
+		pRecord = Reserve(Length, Type);
+		uint32_t Elapsed = osKernelGetTickCount() - Start;
+
+		if ((pRecord != nullptr) || (Elapsed >= Timeout))
+		{
+			break;
+		}
+
+		osEventFlagsWait(m_SpaceFlags, s_SpaceFreedFlag, osFlagsWaitAny | osFlagsNoClear, Timeout - Elapsed);
+	}
+
+	AtomicAdd(&m_SpaceWaiters, (uint32_t)-1);
+
+	return pRecord;
+}
+
+Logger::Record *Logger::Acquire(const LoggerModule *const pModule, size_t Length, RecordType Type)
+{
+	Record *pRecord = Reserve(Length, Type);
+
+	if (pRecord == nullptr)
+	{
+		switch (pModule->GetPolicy())
+		{
+		case LogPolicy::OverwriteOldest:
+			while ((pRecord == nullptr) && Evict())
+			{
+				pRecord = Reserve(Length, Type);
+			}
+			break;
+
+		case LogPolicy::Block:
+			pRecord = WaitForSpace(Length, Type, pModule->GetBlockTimeoutMs());
+			break;
+
+		case LogPolicy::DropNewest:
+		default:
+			break;
+		}
+	}
+
+	LoggerModule::State &ModuleState = LoggerModule::s_States[(size_t)pModule->GetId()];
+	AtomicAdd((pRecord != nullptr) ? &ModuleState.Emitted : &ModuleState.Dropped, 1);
+
+	return pRecord;
+}
+
+bool Logger::LogF(const LoggerModule *const pModule, LogLevel Level, const char *Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	bool Queued = LogV(pModule, Level, Timebase_GetCycles(), Format, Args);
+	va_end(Args);
+
+	return Queued;
+}
+
+bool Logger::LogStampedF(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const char *Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	bool Queued = LogV(pModule, Level, Timestamp, Format, Args);
+	va_end(Args);
+
+	return Queued;
+}
+
+bool Logger::LogV(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const char *Format, va_list Args)
+{
+	va_list MeasureArgs;
+
+	// Measure first so the record only takes the space it needs
+	va_copy(MeasureArgs, Args);
+	size_t Length = Format_VPrint(nullptr, 0, Format, MeasureArgs);
+	va_end(MeasureArgs);
+
+	size_t MessageLength = (Length > s_MaxMessageLength) ? s_MaxMessageLength : Length;
+	Record *pRecord = Acquire(pModule, sizeof(Record) + MessageLength + 1, RecordType::Text);
+
+	if (pRecord != nullptr)
+	{
+		if (Length > MessageLength)
+		{
+			AtomicAdd(&LoggerModule::s_States[(size_t)pModule->GetId()].Truncated, 1);
+		}
+
+		// Record is owned by this producer until it is committed
+		Format_VPrint(pRecord->Message(), MessageLength + 1, Format, Args);
+		pRecord->SetTimestamp(Timestamp);
+
+		Commit(pRecord, Level, pModule->GetId());
+	}
+
+	return (pRecord != nullptr);
+}
+
+bool Logger::LogWords(const LoggerModule *const pModule, LogLevel Level, uint64_t Timestamp, const uint32_t *pWords,
+		size_t NumWords)
+{
+	Record *pRecord = Acquire(pModule, sizeof(Record) + (NumWords * sizeof(uint32_t)), RecordType::Binary);
+
+	if (pRecord == nullptr)
+	{
+		return false;
+	}
+
+	for (size_t Idx = 0; Idx < NumWords; Idx++)
+	{
+		pRecord->Words()[Idx] = pWords[Idx];
+	}
+
+	pRecord->SetTimestamp(Timestamp);
+
+	Commit(pRecord, Level, pModule->GetId());
+
+	return true;
+}
+
+bool Logger::LogWordsFromISR(const LoggerModule *const pModule, LogLevel Level, uint32_t FormatId, const uint32_t *pWords,
+		size_t NumWords)
+{
+	for (IsrRing &Ring : m_IsrRings)
+	{
+		// Busy can only be seen set by an interrupt that preempted the ring's writer,
+		// one preempting between the check and the set has finished before we resume
+		if (Ring.Busy)
+		{
+			continue;
+		}
+
+		Ring.Busy = 1;
+		__DMB();
+
+		uint32_t Head = Ring.Head;
+
+		if ((Head - Ring.Tail) < s_IsrRingLength)
+		{
+			IsrRecord &Record = Ring.Records[Head % s_IsrRingLength];
+			uint64_t Timestamp = Timebase_GetCycles();
+
+			Record.pModule = pModule;
+			Record.FormatId = FormatId;
+			Record.TimestampLow = (uint32_t)Timestamp;
+			Record.TimestampHigh = (uint32_t)(Timestamp >> 32);
+			Record.NumWords = (uint8_t)NumWords;
+			Record.Level = Level;
+
+			for (size_t Idx = 0; Idx < s_MaxIsrArguments; Idx++)
+			{
+				Record.Words[Idx] = pWords[Idx];
+			}
+
+			// Record must be visible before the logger task sees the new head
+			__DMB();
+			Ring.Head = Head + 1;
+			Ring.Busy = 0;
+
+			WakeIfIdle();
+
+			return true;
+		}
+
+		Ring.Busy = 0;
+	}
+
+	AtomicAdd(&LoggerModule::s_States[(size_t)pModule->GetId()].Dropped, 1);
+
+	return false;
+}
+
+void Logger::BenchmarkFromISR(bool Contended, size_t Runs, uint32_t *pFastest, uint32_t *pSlowest)
+{
+	static const uint32_t s_Words[s_MaxIsrArguments] = { 0 };
+	uint32_t Fastest = UINT32_MAX;
+	uint32_t Slowest = 0;
+	uint32_t Overhead = UINT32_MAX;
+
+	// Cost of reading the cycle counter, taken off every call
+	for (size_t Run = 0; Run < 8; Run++)
+	{
+		uint32_t Start = DWT->CYCCNT;
+		uint32_t Cycles = DWT->CYCCNT - Start;
+		Overhead = (Cycles < Overhead) ? Cycles : Overhead;
+	}
+
+	for (size_t Run = 0; Run < Runs; Run++)
+	{
+		uint32_t Heads[s_IsrRings];
+
+		// Neither the logger task nor a logging interrupt can see the rings meanwhile
+		uint32_t Primask = __get_PRIMASK();
+		__disable_irq();
+
+		uint32_t Idle = m_Idle;
+
+		for (size_t Idx = 0; Idx < s_IsrRings; Idx++)
+		{
+			Heads[Idx] = m_IsrRings[Idx].Head;
+		}
+
+		if (Contended)
+		{
+			for (size_t Idx = 0; Idx < (s_IsrRings - 1); Idx++)
+			{
+				m_IsrRings[Idx].Head = m_IsrRings[Idx].Tail + s_IsrRingLength;
+			}
+		}
+
+		m_Idle = Contended ? 1 : 0;
+
+		uint32_t Start = DWT->CYCCNT;
+		LogWordsFromISR(&s_LoggerModule, LogLevel::Debug, 0, s_Words, s_MaxIsrArguments);
+		uint32_t Cycles = DWT->CYCCNT - Start - Overhead;
+
+		// Drop the record, restoring the heads leaves its slot free
+		for (size_t Idx = 0; Idx < s_IsrRings; Idx++)
+		{
+			m_IsrRings[Idx].Head = Heads[Idx];
+		}
+
+		m_Idle = Idle;
+
+		__set_PRIMASK(Primask);
+
+		Fastest = (Cycles < Fastest) ? Cycles : Fastest;
+		Slowest = (Cycles > Slowest) ? Cycles : Slowest;
+	}
+
+	*pFastest = Fastest;
+	*pSlowest = Slowest;
+}
+
+bool Logger::IsIsrPending(void) const
+{
+	for (const IsrRing &Ring : m_IsrRings)
+	{
+		if (Ring.Head != Ring.Tail)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Logger::DrainISR(void)
+{
+	while (1)
+	{
+		// Rings are each in order, merge them by timestamp
+		IsrRing *pOldest = nullptr;
+		uint64_t OldestTimestamp = 0;
+
+		for (IsrRing &Ring : m_IsrRings)
+		{
+			if (Ring.Head == Ring.Tail)
+			{
+				continue;
+			}
+
+			const IsrRecord &Record = Ring.Records[Ring.Tail % s_IsrRingLength];
+			uint64_t Timestamp = ((uint64_t)Record.TimestampHigh << 32) | Record.TimestampLow;
+
+			if ((pOldest == nullptr) || (Timestamp < OldestTimestamp))
+			{
+				pOldest = &Ring;
+				OldestTimestamp = Timestamp;
+			}
+		}
+
+		if (pOldest == nullptr)
+		{
+			break;
+		}
+
+		__DMB();
+		const IsrRecord &Record = pOldest->Records[pOldest->Tail % s_IsrRingLength];
+
+		// Counted as emitted or dropped once it is in, or can't get into, the arena
+
+#if defined(LOG_BINARY)
+		uint32_t Words[s_MaxIsrArguments + 1] = { Record.FormatId };
+
+		for (size_t Idx = 0; Idx < Record.NumWords; Idx++)
+		{
+			Words[Idx + 1] = Record.Words[Idx];
+		}
+
+		LogWords(Record.pModule, Record.Level, OldestTimestamp, Words, Record.NumWords + 1);
+#else
+		// Surplus arguments are ignored by the formatter
+		LogStampedF(Record.pModule, Record.Level, OldestTimestamp, (const char *)(uintptr_t)Record.FormatId,
+				Record.Words[0], Record.Words[1], Record.Words[2], Record.Words[3]);
+#endif
+
+		__DMB();
+		pOldest->Tail = pOldest->Tail + 1;
+	}
+}
+
+/**
+ * @brief	Appends an unsigned LEB128 encoded value
+ * @retval	Pointer past the last byte written
+ */
+static uint8_t *EncodeVarint(uint8_t *pOut, uint64_t Value)
+{
+	while (Value >= 0x80)
+	{
+		*pOut++ = (uint8_t)(Value | 0x80);
+		Value >>= 7;
+	}
+
+	*pOut++ = (uint8_t)Value;
+	return pOut;
+}
+
+size_t Logger::EncodeFrame(const Record *pRecord, uint8_t *pFrame)
+{
+	uint8_t *pOut = &pFrame[2];
+	uint32_t Header = pRecord->Header;
+
+	// Timestamps are sent as zigzag cycle deltas, interrupt records can be older than
+	// the record before them. Module names are sent as offsets into flash.
+	uint64_t Timestamp = pRecord->GetTimestamp();
+	int64_t Delta = (int64_t)(Timestamp - m_LastTimestamp);
+	pOut = EncodeVarint(pOut, ((uint64_t)Delta << 1) ^ (uint64_t)(Delta >> 63));
+	pOut = EncodeVarint(pOut, (uint32_t)(uintptr_t)LoggerModule::GetModuleName(Record::GetModule(Header)) - FLASH_BASE);
+	m_LastTimestamp = Timestamp;
+
+	if (Record::GetType(Header) == RecordType::Binary)
+	{
+		size_t NumWords = (Record::GetSize(Header) - sizeof(Record)) / sizeof(uint32_t);
+
+		for (size_t Idx = 0; Idx < NumWords; Idx++)
+		{
+			pOut = EncodeVarint(pOut, pRecord->Words()[Idx]);
+		}
+	}
+	else
+	{
+		// Text records carry the reserved format ID followed by the raw text
+		size_t Length = strlen(pRecord->Message());
+		pOut = EncodeVarint(pOut, s_TextFormatId);
+		memcpy(pOut, pRecord->Message(), Length);
+		pOut += Length;
+	}
+
+	pFrame[0] = s_FrameSync;
+	pFrame[1] = (uint8_t)(pOut - &pFrame[2]);
+
+	return pOut - pFrame;
+}
+
+size_t Logger::Render(const Record *pRecord, uint8_t *pOut)
+{
+#if defined(LOG_BINARY)
+	return EncodeFrame(pRecord, pOut);
+#else
+	// Binary records can only be rendered by the host decoder
+	size_t Length = 0;
+
+	if (Record::GetType(pRecord->Header) == RecordType::Text)
+	{
+		uint64_t Us = Timebase_CyclesToUs(pRecord->GetTimestamp());
+		size_t MessageLength = strlen(pRecord->Message());
+		const char *pName = LoggerModule::GetModuleName(Record::GetModule(pRecord->Header));
+		int Padding = (int)LoggerModule::s_MaxModuleNameLength - (int)strlen(pName) - 1;
+
+		// Names are only looked up here, records carry the module ID
+		Length += Format_Print((char *)pOut, s_MaxFrameLength, "[%5lu.%06lu] %s:%*s",
+				(unsigned long)(Us / 1000000), (unsigned long)(Us % 1000000), pName, (Padding > 0) ? Padding : 0, "");
+		memcpy(&pOut[Length], pRecord->Message(), MessageLength);
+		Length += MessageLength;
+		memcpy(&pOut[Length], s_NewLine, sizeof(s_NewLine) - 1);
+		Length += sizeof(s_NewLine) - 1;
+	}
+
+	return Length;
+#endif
+}
+
+size_t Logger::PayloadLength(const Record *pRecord)
+{
+	uint32_t Header = pRecord->Header;
+
+	return (Record::GetType(Header) == RecordType::Text) ? strlen(pRecord->Message()) :
+			(Record::GetSize(Header) - sizeof(Record));
+}
+
+uint32_t Logger::HashRecord(const Record *pRecord)
 {
-	strncpy(m_ModuleName, ModuleName, s_MaxModuleNameLength);
+	// FNV-1a over everything but the size, state and timestamp
+	uint32_t Header = pRecord->Header;
+	uint32_t Hash = 2166136261u;
+	const uint8_t *pPayload = (const uint8_t *)pRecord->Words();
+	size_t Length = PayloadLength(pRecord);
 
-	m_ModuleName[s_MaxModuleNameLength] = 0;
+	Hash = (Hash ^ (Header >> 16)) * 16777619u;
 
-	size_t Idx = strlen(ModuleName);
-	m_ModuleName[Idx++] = ':';
-	while (Idx < s_MaxModuleNameLength)
+	for (size_t Idx = 0; Idx < Length; Idx++)
 	{
-		m_ModuleName[Idx++] = ' ';
+		Hash = (Hash ^ pPayload[Idx]) * 16777619u;
 	}
 
-	asm("NOP");
+	return Hash;
 }
 
-LoggerModule::~LoggerModule()
+bool Logger::IsRepeat(const Record *pRecord, uint32_t Hash) const
 {
+	if ((Hash != m_LastHash) || ((pRecord->Header >> 16) != m_LastKey))
+	{
+		return false;
+	}
+
+	size_t Length = PayloadLength(pRecord);
+	size_t Compare = (Length < s_RepeatCompareLength) ? Length : s_RepeatCompareLength;
+
+	return (Length == m_LastLength) && (memcmp(pRecord->Words(), m_LastPrefix, Compare) == 0);
 }
 
-const char * LoggerModule::GetModuleName(void) const
+void Logger::RememberRecord(const Record *pRecord, uint32_t Hash)
 {
-	return m_ModuleName;
+	size_t Length = PayloadLength(pRecord);
+	size_t Compare = (Length < s_RepeatCompareLength) ? Length : s_RepeatCompareLength;
+
+	m_LastHash = Hash;
+	m_LastKey = pRecord->Header >> 16;
+	m_LastLength = Length;
+	memcpy(m_LastPrefix, pRecord->Words(), Compare);
 }
 
-Logger& Logger::Instance(void)
+size_t Logger::RenderRepeats(uint8_t *pOut)
 {
-	static Logger Instance;
-	return Instance;
+	// Rendered through a stand-in record of the repeated module so it reads like any other
+	struct
+	{
+		Record Header;
+		uint32_t Payload[s_RepeatsPayloadWords];
+	} Notice;
+
+#if defined(LOG_BINARY)
+	Notice.Payload[0] = LOGGER_FORMAT_ID("last message repeated %lu times");
+	Notice.Payload[1] = m_Repeats;
+	Notice.Header.Header = Record::MakeHeader(sizeof(Record) + (2 * sizeof(uint32_t)), RecordState::Committed,
+			RecordType::Binary, LogLevel::Info, m_RepeatModule);
+#else
+	Format_Print((char *)Notice.Payload, sizeof(Notice.Payload), "last message repeated %lu times",
+			(unsigned long)m_Repeats);
+	Notice.Header.Header = Record::MakeHeader(sizeof(Notice), RecordState::Committed, RecordType::Text,
+			LogLevel::Info, m_RepeatModule);
+#endif
+
+	Notice.Header.SetTimestamp(m_RepeatTimestamp);
+	m_Repeats = 0;
+
+	return Render(&Notice.Header, pOut);
 }
 
-Logger::Logger(void) :
-	m_CurrentBuff(0),
-	m_BuffPos(0),
-	m_UART(&huart1)
+bool Logger::AddSink(LoggerSink *pSink)
 {
+	if (m_NumSinks >= s_MaxSinks)
+	{
+		return false;
+	}
+
+	m_Sinks[m_NumSinks++] = pSink;
+	return true;
 }
 
-Logger::~Logger()
+size_t Logger::GetNumSinks(void) const
+{
+	return m_NumSinks;
+}
+
+LoggerSink *Logger::GetSink(size_t Idx) const
+{
+	return (Idx < m_NumSinks) ? m_Sinks[Idx] : nullptr;
+}
+
+LoggerSink *Logger::FindSink(const char *Name) const
+{
+	for (size_t Idx = 0; Idx < m_NumSinks; Idx++)
+	{
+		if (strcmp(m_Sinks[Idx]->GetName(), Name) == 0)
+		{
+			return m_Sinks[Idx];
+		}
+	}
+
+	return nullptr;
+}
+
+uint32_t Logger::LeadingCursor(void) const
 {
+	// With no sink to send to, output is rendered and thrown away so the arena keeps draining
+	uint32_t MinLag = 0;
+	bool Active = false;
+
+	for (size_t Idx = 0; Idx < m_NumSinks; Idx++)
+	{
+		const LoggerSink *pSink = m_Sinks[Idx];
+
+		if (pSink->IsEnabled() && pSink->IsAvailable())
+		{
+			uint32_t Lag = m_OutputHead - pSink->m_Cursor;
+
+			if (!Active || (Lag < MinLag))
+			{
+				MinLag = Lag;
+				Active = true;
+			}
+		}
+	}
+
+	return m_OutputHead - ((MinLag > s_OutputSize) ? s_OutputSize : MinLag);
 }
 
-bool Logger::LogF(const LoggerModule *const pModule, const char *Format, ...)
+bool Logger::ServiceSink(LoggerSink *pSink)
 {
-	bool ret = true;
+	// Sinks that are off or have nowhere to send follow the head, they resume with fresh output
+	if (!pSink->IsEnabled() || !pSink->IsAvailable())
+	{
+		pSink->m_Cursor = m_OutputHead;
+		return false;
+	}
+
+	if (pSink->IsBusy())
+	{
+		return false;
+	}
 
-	if (m_BuffPos < s_QueueSize)
+	uint32_t Lag = m_OutputHead - pSink->m_Cursor;
+
+	if (Lag > s_OutputSize)
 	{
-		strcpy(&m_Buff[m_CurrentBuff][m_BuffPos][0], pModule->GetModuleName());
+		// Fell a whole output behind, skip to the oldest output still there
+		pSink->m_Dropped = pSink->m_Dropped + (Lag - s_OutputSize);
+		pSink->m_Cursor = m_OutputHead - s_OutputSize;
+		Lag = s_OutputSize;
+	}
 
-		va_list Args;
-		va_start(Args, Format);
-		vsnprintf(&m_Buff[m_CurrentBuff][m_BuffPos][LoggerModule::s_MaxModuleNameLength], s_MaxMessageLength, Format, Args);
-		va_end(Args);
+	if (Lag == 0)
+	{
+		return false;
+	}
 
-		strcat(&m_Buff[m_CurrentBuff][m_BuffPos][0], s_NewLine);
+	size_t Length = (Lag > LoggerSink::s_BufferSize) ? LoggerSink::s_BufferSize : Lag;
 
-		m_BuffPos++;
+	for (size_t Idx = 0; Idx < Length; Idx++)
+	{
+		pSink->m_Buffer[Idx] = m_Output[(pSink->m_Cursor + Idx) % s_OutputSize];
 	}
-	else
+
+	if (!pSink->Transmit(Length))
+	{
+		return false;
+	}
+
+	pSink->m_Cursor += Length;
+	return true;
+}
+
+Logger::Record *Logger::Oldest(void) const
+{
+	return (Record *)&m_Arena[m_Tail % s_ArenaSize];
+}
+
+bool Logger::IsPending(void) const
+{
+	RecordState State = Record::GetState(Oldest()->Header);
+	return ((State == RecordState::Committed) || (State == RecordState::Padding));
+}
+
+uint32_t Logger::CalculateSealCrc(void) const
+{
+	const uint32_t Positions[] = { m_Head, m_Tail, m_SealMagic };
+
+	Crc_Reset();
+	Crc_Accumulate((const uint32_t *)m_Arena, s_ArenaSize / sizeof(uint32_t));
+
+	return Crc_Accumulate(Positions, sizeof(Positions) / sizeof(Positions[0]));
+}
+
+bool Logger::Recover(void)
+{
+	if ((m_SealMagic != s_SealMagic) || (CalculateSealCrc() != m_SealCrc) || ((m_Head - m_Tail) > s_ArenaSize))
+	{
+		return false;
+	}
+
+	// Seal left nothing but committed records and padding, anything else means the
+	// arena was changed after sealing
+	size_t Recovered = 0;
+
+	for (uint32_t Position = m_Tail; Position != m_Head; )
+	{
+		uint32_t Header = ((const Record *)&m_Arena[Position % s_ArenaSize])->Header;
+		size_t Size = Record::GetSize(Header);
+		RecordState State = Record::GetState(Header);
+
+		if ((Size == 0) || ((Size % sizeof(uint32_t)) != 0) || (Size > (m_Head - Position)) ||
+			((State != RecordState::Committed) && (State != RecordState::Padding)))
+		{
+			return false;
+		}
+
+		Recovered += (State == RecordState::Committed) ? 1 : 0;
+		Position += Size;
+	}
+
+	m_Recovered = Recovered;
+
+	return true;
+}
+
+void Logger::Seal(void)
+{
+	uint32_t Position = m_Tail;
+
+	while (Position != m_Head)
+	{
+		uint32_t Header = ((const Record *)&m_Arena[Position % s_ArenaSize])->Header;
+		size_t Size = Record::GetSize(Header);
+		RecordState State = Record::GetState(Header);
+
+		// Records being written or released when everything stopped can't be trusted,
+		// and the arena is strictly ordered so neither can anything after them
+		if ((Size == 0) || ((State != RecordState::Committed) && (State != RecordState::Padding)))
+		{
+			break;
+		}
+
+		Position += Size;
+	}
+
+	// Keep what was cut off zeroed like the rest of the free space
+	for (uint32_t Idx = Position; Idx != (m_Tail + s_ArenaSize); Idx++)
+	{
+		m_Arena[Idx % s_ArenaSize] = 0;
+	}
+
+	m_Head = Position;
+	m_SealMagic = s_SealMagic;
+	m_SealCrc = CalculateSealCrc();
+}
+
+size_t Logger::GetRecovered(void) const
+{
+	return m_Recovered;
+}
+
+void Logger::Panic(void)
+{
+	m_Panicked = true;
+}
+
+void Logger::Release(Record *pRecord, size_t Size)
+{
+	// Keep free space zeroed, then hand it back
+	memset(pRecord, 0, Size);
+	__DMB();
+	m_Tail = m_Tail + Size;
+}
+
+bool Logger::RenderNext(void)
+{
+	bool Rendered = false;
+	bool Released = false;
+	bool Journaled = false;
+
+	while (!Rendered)
+	{
+		if (!TryLockTail())
+		{
+			// A producer is evicting, let it finish
+			osDelay(1);
+			continue;
+		}
+
+		bool Pending = IsPending();
+
+		if (Pending)
+		{
+			Record *pRecord = Oldest();
+			uint32_t Header = pRecord->Header;
+
+			bool Keep = false;
+
+			if (Record::GetState(Header) == RecordState::Committed)
+			{
+				uint32_t Hash = HashRecord(pRecord);
+
+				if (IsRepeat(pRecord, Hash))
+				{
+					// Same as the last one out, only count it
+					if (m_Repeats++ == 0)
+					{
+						m_RepeatTick = osKernelGetTickCount();
+					}
+
+					m_RepeatTimestamp = pRecord->GetTimestamp();
+				}
+				else if (m_Repeats > 0)
+				{
+					// Close off the run first, the record goes out next time round
+					m_FrameLength = RenderRepeats(m_Frame);
+					m_FrameOffset = 0;
+					Rendered = true;
+					Keep = true;
+				}
+				else
+				{
+					m_FrameLength = Render(pRecord, m_Frame);
+					m_FrameOffset = 0;
+					RememberRecord(pRecord, Hash);
+					m_RepeatModule = Record::GetModule(Header);
+					Rendered = (m_FrameLength > 0);
+					Journaled = Rendered && (Record::GetLevel(Header) >= LOG_JOURNAL_LEVEL);
+				}
+			}
+
+			if (!Keep)
+			{
+				// Record is copied out, hand the space straight back to producers
+				Release(pRecord, Record::GetSize(Header));
+				Released = true;
+			}
+		}
+
+		UnlockTail();
+
+		if (!Pending)
+		{
+			break;
+		}
+	}
+
+	// Runs still going when the arena empties are reported at most a timeout after they start
+	if (!Rendered && (m_Repeats > 0) &&
+		((osKernelGetTickCount() - m_RepeatTick) >= pdMS_TO_TICKS(s_RepeatTimeoutMs)))
+	{
+		m_FrameLength = RenderRepeats(m_Frame);
+		m_FrameOffset = 0;
+		Rendered = true;
+	}
+
+	if (Released && (m_SpaceWaiters != 0))
+	{
+		osEventFlagsSet(m_SpaceFlags, s_SpaceFreedFlag);
+	}
+
+	// Only copied here, the journal task programs flash later
+	if (Journaled)
 	{
-		ret = false;
+		Journal_Append(Journal_Log, m_Frame, m_FrameLength);
 	}
 
-	return ret;
+	return Rendered;
 }
 
 void Logger::Flush(void)
 {
-	uint8_t Idx = 0;
-	uint8_t BuffToFlush = m_CurrentBuff;
-	m_CurrentBuff = !m_CurrentBuff;
+	while (1)
+	{
+		// Render as far as the leading sink has room for. Records are split across
+		// transfers, so transfers queued up while a sink is busy always leave full.
+		uint32_t Room = s_OutputSize - (m_OutputHead - LeadingCursor());
+
+		while (Room > 0)
+		{
+			if ((m_FrameOffset == m_FrameLength) && !RenderNext())
+			{
+				break;
+			}
+
+			size_t Length = m_FrameLength - m_FrameOffset;
+
+			if (Length > Room)
+			{
+				Length = Room;
+			}
+
+			for (size_t Idx = 0; Idx < Length; Idx++)
+			{
+				m_Output[(m_OutputHead + Idx) % s_OutputSize] = m_Frame[m_FrameOffset + Idx];
+			}
+
+			m_OutputHead += Length;
+			m_FrameOffset += Length;
+			Room -= Length;
+		}
+
+		// Only a busy leading sink can leave us without room, its completion wakes us
+		m_OutputStalled = (Room == 0);
+
+		bool Started = false;
+
+		for (size_t Idx = 0; Idx < m_NumSinks; Idx++)
+		{
+			Started |= ServiceSink(m_Sinks[Idx]);
+		}
+
+		if (!Started)
+		{
+			// Transmit complete notifications bring us back for the rest
+			break;
+		}
+	}
+}
+
+void Logger::WaitForWork(void)
+{
+	m_Idle = 1;
+	__DMB();
+
+	// Re-check after advertising idle so a commit racing with us isn't missed. Pending
+	// records can wait while the output is full, a sink completing will wake us.
+	if (m_OutputStalled || (!IsPending() && !IsIsrPending()))
+	{
+		// Sleep no longer than the next counter summary, or repeat notice if a run is open
+		uint32_t Now = osKernelGetTickCount();
+		uint32_t Elapsed = Now - m_LastSummaryTick;
+		uint32_t Period = pdMS_TO_TICKS(s_SummaryPeriodMs);
+		uint32_t Timeout = (Elapsed < Period) ? (Period - Elapsed) : 0;
+
+		if (m_Repeats > 0)
+		{
+			uint32_t RepeatElapsed = Now - m_RepeatTick;
+			uint32_t RepeatTimeout = pdMS_TO_TICKS(s_RepeatTimeoutMs);
+			uint32_t RepeatLeft = (RepeatElapsed < RepeatTimeout) ? (RepeatTimeout - RepeatElapsed) : 0;
+
+			Timeout = (RepeatLeft < Timeout) ? RepeatLeft : Timeout;
+		}
+
+		ulTaskNotifyTake(pdTRUE, Timeout);
+	}
+
+	m_Idle = 0;
+}
+
+void Logger::Summarise(void)
+{
+	uint32_t Now = osKernelGetTickCount();
+
+	if ((Now - m_LastSummaryTick) < pdMS_TO_TICKS(s_SummaryPeriodMs))
+	{
+		return;
+	}
+
+	m_LastSummaryTick = Now;
+
+	auto GetTotal = [](size_t Id)
+	{
+		const LoggerModule::State &State = LoggerModule::s_States[Id];
+		return State.Emitted + State.Dropped + State.Truncated + State.Limited;
+	};
 
-	while (Idx < m_BuffPos)
+	for (size_t Id = 0; Id < (size_t)LogModuleId::Count; Id++)
 	{
-#if defined(LOG_TO_USB)
-		CDC_Transmit_FS((uint8_t*)&m_Buff[BuffToFlush][Idx][0], strlen(&m_Buff[BuffToFlush][Idx][0]));
-		m_Transmitting = true;
-#elif defined(LOG_TO_UART)
-		while (HAL_UART_Transmit_IT(m_UART, (uint8_t*)&m_Buff[BuffToFlush][Idx][0], strlen(&m_Buff[BuffToFlush][Idx][0])) != HAL_OK)
+		const LoggerModule::State &State = LoggerModule::s_States[Id];
+		uint32_t Total = GetTotal(Id);
+
+		if (Total == m_SummaryTotals[Id])
 		{
-			taskYIELD();
+			continue;
 		}
-#elif defined(LOG_TO_PRINTF)
-		printf(&m_Buff[BuffToFlush][Idx][0]);
-#endif
 
-		Idx++;
+		m_SummaryTotals[Id] = Total;
+
+		LOG_INFO(&s_LoggerModule, "%s emitted %lu dropped %lu truncated %lu limited %lu", s_ModuleNames[Id],
+				State.Emitted, State.Dropped, State.Truncated, State.Limited);
+	}
+
+	// The summary's own lines count against the logger's module, they're not news
+	m_SummaryTotals[(size_t)LogModuleId::Logger] = GetTotal((size_t)LogModuleId::Logger);
+}
+
+void Logger::Wake(void)
+{
+	if ((m_TaskHandle == nullptr) || m_Panicked)
+	{
+		return;
+	}
+
+	if (__get_IPSR() != 0)
+	{
+		BaseType_t Woken = pdFALSE;
+		vTaskNotifyGiveFromISR((TaskHandle_t)m_TaskHandle, &Woken);
+		portYIELD_FROM_ISR(Woken);
+	}
+	else
+	{
+		xTaskNotifyGive((TaskHandle_t)m_TaskHandle);
+	}
+}
+
+void Logger::Commit(Record *pRecord, LogLevel Level, LogModuleId Module)
+{
+	// Payload must be visible before the flusher sees the record as committed
+	uint32_t Header = pRecord->Header;
+	__DMB();
+	pRecord->Header = Record::MakeHeader(Record::GetSize(Header), RecordState::Committed, Record::GetType(Header),
+			Level, Module);
+	__DMB();
+
+	WakeIfIdle();
+}
+
+void Logger::WakeIfIdle(void)
+{
+	// Only the first record after the logger goes idle pays for a wakeup
+	if (m_Idle && CompareAndSwap(&m_Idle, 1, 0))
+	{
+		Wake();
 	}
+}
 
-	m_BuffPos = 0;
+void Logger::TransmitComplete(void)
+{
+	Wake();
 }
 
 void Logger_Task(void *pvParamaters)
@@ -115,18 +1220,137 @@ void Logger_Task(void *pvParamaters)
 
 	while (1)
 	{
-		osDelay(10);
+		LOGGER.WaitForWork();
+		LOGGER.DrainISR();
+		LOGGER.Summarise();
 		LOGGER.Flush();
 	}
 }
 
+extern "C" void Logger_TransmitCompleteInterruptCallback(void)
+{
+	LOGGER.TransmitComplete();
+}
+
+// EXC_RETURN bit set when the interrupted code was on the process stack
+static constexpr uint32_t s_ExcReturnProcessStack = 0x04;
+
+// r0-r3, r12, lr, pc and xPSR, stacked by the core on exception entry
+static constexpr size_t s_ExceptionFrameWords = 8;
+
+extern "C" void Logger_Fault(const char *Name, uint32_t ExcReturn)
+{
+	LOGGER.Panic();
+
+	// Task frames are exactly where PSP points. Frames on the main stack sit under
+	// whatever the handler pushed itself, so only the fault status is known for them.
+	uint32_t Psp = __get_PSP();
+
+	if (((ExcReturn & s_ExcReturnProcessStack) != 0) && (Psp >= SRAM_BASE) &&
+		((Psp + (s_ExceptionFrameWords * sizeof(uint32_t))) <= (uint32_t)(uintptr_t)&_estack))
+	{
+		const uint32_t *pFrame = (const uint32_t *)(uintptr_t)Psp;
+
+		LOG_ERROR(&s_FaultModule, "%s r0 %08lx r1 %08lx r2 %08lx r3 %08lx r12 %08lx lr %08lx pc %08lx psr %08lx",
+				Name, pFrame[0], pFrame[1], pFrame[2], pFrame[3], pFrame[4], pFrame[5], pFrame[6], pFrame[7]);
+	}
+	else
+	{
+		LOG_ERROR(&s_FaultModule, "%s on main stack, exc_return %08lx", Name, ExcReturn);
+	}
+
+	LOG_ERROR(&s_FaultModule, "cfsr %08lx hfsr %08lx mmfar %08lx bfar %08lx", SCB->CFSR, SCB->HFSR, SCB->MMFAR, SCB->BFAR);
+
+	LOGGER.Seal();
+	NVIC_SystemReset();
+}
+
+extern "C" void Logger_AssertFailed(const char *File, int Line)
+{
+	__disable_irq();
+	LOGGER.Panic();
+
+	LOG_ERROR(&s_FaultModule, "Assert failed %s:%d", File, Line);
+
+	LOGGER.Seal();
+	NVIC_SystemReset();
+}
+
+extern "C" void Logger_StackOverflow(const char *pTaskName)
+{
+	__disable_irq();
+	LOGGER.Panic();
+
+	LOG_ERROR(&s_FaultModule, "Stack overflow in %s", pTaskName);
+
+	LOGGER.Seal();
+	NVIC_SystemReset();
+}
+
+/**
+ * @brief	"log" command, lists sinks or switches one on or off
+ */
+static void LogCommand(int Argc, char *pArgv[])
+{
+	if ((Argc == 4) && (strcmp(pArgv[1], "sink") == 0))
+	{
+		LoggerSink *pSink = LOGGER.FindSink(pArgv[2]);
+		bool On = (strcmp(pArgv[3], "on") == 0);
+
+		if ((pSink == nullptr) || (!On && (strcmp(pArgv[3], "off") != 0)))
+		{
+			LOG_WARN(&s_LoggerModule, "No such sink or state");
+			return;
+		}
+
+		pSink->SetEnabled(On);
+	}
+	else if ((Argc != 2) || (strcmp(pArgv[1], "sinks") != 0))
+	{
+		LOG_WARN(&s_LoggerModule, "Usage: log sinks | log sink <name> on|off");
+		return;
+	}
+
+	for (size_t Idx = 0; Idx < LOGGER.GetNumSinks(); Idx++)
+	{
+		const LoggerSink *pSink = LOGGER.GetSink(Idx);
+
+		LOG_INFO(&s_LoggerModule, "%s %s%s, %lu bytes dropped", pSink->GetName(), pSink->IsEnabled() ? "on" : "off",
+				pSink->IsAvailable() ? "" : " (unavailable)", pSink->GetDropped());
+	}
+}
+
 void Logger_Init(void)
 {
+	static UartLoggerSink Uart1Sink("uart1", LOG_TO_UART1, &huart1);
+	static UsbLoggerSink UsbSink("usb", LOG_TO_USB);
+	static SemihostingLoggerSink SemihostingSink("semihost", LOG_TO_SEMIHOSTING);
+
+	LOGGER.AddSink(&Uart1Sink);
+	LOGGER.AddSink(&UsbSink);
+	LOGGER.AddSink(&SemihostingSink);
+
+	Command_Register("log", LogCommand, "log sinks | log sink <name> on|off");
+
 	const osThreadAttr_t TaskAttributes = {
 		.name = "Logger_Task",
 		.stack_size = 128 * 4,
 		.priority = (osPriority_t) osPriorityNormal,
 	};
 
+	static StaticEventGroup_t SpaceFlagsControlBlock;
+
+	const osEventFlagsAttr_t SpaceFlagsAttributes = {
+		.name = "Logger_Space",
+		.cb_mem = &SpaceFlagsControlBlock,
+		.cb_size = sizeof(SpaceFlagsControlBlock),
+	};
+
+	LOGGER.m_SpaceFlags = osEventFlagsNew(&SpaceFlagsAttributes);
 	LOGGER.m_TaskHandle = osThreadNew(Logger_Task, nullptr, &TaskAttributes);
+
+	if (LOGGER.GetRecovered() > 0)
+	{
+		LOG_WARN(&s_LoggerModule, "%u records above are from before the last reset", (unsigned)LOGGER.GetRecovered());
+	}
 }
@@ -0,0 +1,146 @@
+/*
+ * logger_sink.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "logger_sink.h"
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+LoggerSink::LoggerSink(const char *Name, bool Enabled) :
+	m_Buffer(),
+	m_pName(Name),
+	m_Enabled(Enabled),
+	m_Cursor(0),
+	m_Dropped(0)
+{
+}
+
+const char *LoggerSink::GetName(void) const
+{
+	return m_pName;
+}
+
+void LoggerSink::SetEnabled(bool Enabled)
+{
+	m_Enabled = Enabled;
+}
+
+bool LoggerSink::IsEnabled(void) const
+{
+	return m_Enabled;
+}
+
+uint32_t LoggerSink::GetDropped(void) const
+{
+	return m_Dropped;
+}
+
+bool LoggerSink::IsAvailable(void) const
+{
+	return true;
+}
+
+UartLoggerSink::UartLoggerSink(const char *Name, bool Enabled, UART_HandleTypeDef *pUART) :
+	LoggerSink(Name, Enabled),
+	m_pUART(pUART)
+{
+}
+
+bool UartLoggerSink::IsBusy(void) const
+{
+	return (m_pUART->gState != HAL_UART_STATE_READY);
+}
+
+bool UartLoggerSink::Transmit(size_t Length)
+{
+	if (m_pUART->hdmatx != nullptr)
+	{
+		return (HAL_UART_Transmit_DMA(m_pUART, m_Buffer, Length) == HAL_OK);
+	}
+
+	return (HAL_UART_Transmit_IT(m_pUART, m_Buffer, Length) == HAL_OK);
+}
+
+UsbLoggerSink::UsbLoggerSink(const char *Name, bool Enabled) :
+	LoggerSink(Name, Enabled)
+{
+}
+
+bool UsbLoggerSink::IsAvailable(void) const
+{
+	return (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED);
+}
+
+bool UsbLoggerSink::IsBusy(void) const
+{
+	// Class data only exists while a host has the device configured
+	const USBD_CDC_HandleTypeDef *pCDC = (const USBD_CDC_HandleTypeDef *)hUsbDeviceFS.pClassData;
+	return ((pCDC != nullptr) && (pCDC->TxState != 0));
+}
+
+bool UsbLoggerSink::Transmit(size_t Length)
+{
+	return (CDC_Transmit_FS(m_Buffer, Length) == USBD_OK);
+}
+
+// ARM semihosting operations
+static constexpr uint32_t s_SemihostingOpen = 0x01;
+static constexpr uint32_t s_SemihostingWrite = 0x05;
+
+// SYS_OPEN mode for writing, ":tt" opened with it is the debugger console
+static constexpr uint32_t s_SemihostingModeWrite = 4;
+
+/**
+ * @brief	Hands a semihosting request to the debugger
+ * @retval	Operation result
+ */
+static int32_t Semihost(uint32_t Operation, const void *pArguments)
+{
+	register uint32_t Result asm("r0") = Operation;
+	register const void *Arguments asm("r1") = pArguments;
+
+	asm volatile ("bkpt 0xAB" : "+r" (Result) : "r" (Arguments) : "memory");
+
+	return (int32_t)Result;
+}
+
+SemihostingLoggerSink::SemihostingLoggerSink(const char *Name, bool Enabled) :
+	LoggerSink(Name, Enabled),
+	m_Handle(-1)
+{
+}
+
+bool SemihostingLoggerSink::IsAvailable(void) const
+{
+	// BKPT without a debugger escalates to a hard fault
+	return ((CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) != 0);
+}
+
+bool SemihostingLoggerSink::IsBusy(void) const
+{
+	// Transfers complete before Transmit returns
+	return false;
+}
+
+bool SemihostingLoggerSink::Transmit(size_t Length)
+{
+	if (m_Handle < 0)
+	{
+		static const char s_Console[] = ":tt";
+		const uint32_t OpenArguments[] = { (uint32_t)(uintptr_t)s_Console, s_SemihostingModeWrite, sizeof(s_Console) - 1 };
+		m_Handle = Semihost(s_SemihostingOpen, OpenArguments);
+
+		if (m_Handle < 0)
+		{
+			return false;
+		}
+	}
+
+	const uint32_t WriteArguments[] = { (uint32_t)m_Handle, (uint32_t)(uintptr_t)m_Buffer, (uint32_t)Length };
+
+	// Returns the number of bytes not written
+	return (Semihost(s_SemihostingWrite, WriteArguments) == 0);
+}
@@ -0,0 +1,173 @@
+/*
+ * sensor_cache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "sensor_cache.h"
+
+#include "logger.h"
+#include "command.h"
+
+static constexpr LoggerModule s_SensorModule(LogModuleId::Sensor);
+
+SensorCacheBase *SensorCacheBase::s_pCaches[s_MaxCaches];
+volatile size_t SensorCacheBase::s_NumCaches = 0;
+
+SensorCacheBase::SensorCacheBase(uint32_t MinIntervalMs) :
+	m_MinIntervalMs(MinIntervalMs),
+	m_LockControlBlock(),
+	m_Lock(xSemaphoreCreateMutexStatic(&m_LockControlBlock)),
+	m_Reading(),
+	m_LastReadTick(0),
+	m_EverRead(false)
+{
+	if (s_NumCaches < s_MaxCaches)
+	{
+		s_pCaches[s_NumCaches] = this;
+		s_NumCaches = s_NumCaches + 1;
+	}
+}
+
+bool SensorCacheBase::IsFresh(uint32_t MaxAgeMs) const
+{
+	return m_Reading.Valid && ((osKernelGetTickCount() - m_Reading.Tick) <= pdMS_TO_TICKS(MaxAgeMs));
+}
+
+bool SensorCacheBase::NeedsRead(uint32_t MaxAgeMs) const
+{
+	if (IsFresh(MaxAgeMs))
+	{
+		return false;
+	}
+
+	return !m_EverRead || ((osKernelGetTickCount() - m_LastReadTick) >= pdMS_TO_TICKS(m_MinIntervalMs));
+}
+
+void SensorCacheBase::Update(const DhtMeasurement &Measurement, bool Valid)
+{
+	m_EverRead = true;
+	m_LastReadTick = osKernelGetTickCount();
+
+	if (!Valid)
+	{
+		LOG_DEBUG(&s_SensorModule, "Read failed, keeping reading from %lu", m_Reading.Tick);
+		return;
+	}
+
+	m_Reading.Temperature = Measurement.Temperature;
+	m_Reading.Humidity = Measurement.Humidity;
+	m_Reading.Tick = m_LastReadTick;
+	m_Reading.Valid = true;
+}
+
+SensorReading SensorCacheBase::Peek(void) const
+{
+	// Copied under the lock, a read may be updating it
+	xSemaphoreTake(m_Lock, portMAX_DELAY);
+	SensorReading Reading = m_Reading;
+	xSemaphoreGive(m_Lock);
+
+	return Reading;
+}
+
+template <typename Sensor>
+SensorCache<Sensor>::SensorCache(Sensor *pSensor) :
+	SensorCacheBase(Sensor::s_MinIntervalMs),
+	m_pSensor(pSensor)
+{
+}
+
+template <typename Sensor>
+bool SensorCache<Sensor>::Get(SensorReading *pReading, uint32_t MaxAgeMs)
+{
+	SensorCache *pCache = this;
+	return (GetAll(&pCache, 1, pReading, MaxAgeMs) == 1);
+}
+
+template <typename Sensor>
+size_t SensorCache<Sensor>::GetAll(SensorCache *const *ppCaches, size_t NumCaches, SensorReading *pReadings,
+		uint32_t MaxAgeMs)
+{
+	Sensor *pSensors[Sensor::s_QueueLength];
+	size_t Reading[Sensor::s_QueueLength];
+	uint8_t Responses[Sensor::s_QueueLength][5];
+	bool Valid[Sensor::s_QueueLength];
+	size_t NumReads = 0, NumFresh = 0;
+
+	NumCaches = (NumCaches < Sensor::s_QueueLength) ? NumCaches : Sensor::s_QueueLength;
+
+	// Waiting here for a read in flight is how a caller joins it
+	for (size_t Idx = 0; Idx < NumCaches; Idx++)
+	{
+		xSemaphoreTake(ppCaches[Idx]->m_Lock, portMAX_DELAY);
+
+		if (ppCaches[Idx]->NeedsRead(MaxAgeMs))
+		{
+			pSensors[NumReads] = ppCaches[Idx]->m_pSensor;
+			Reading[NumReads] = Idx;
+			NumReads++;
+		}
+	}
+
+	if (NumReads > 0)
+	{
+		Sensor::ReadBlocking(pSensors, NumReads, Responses, Valid);
+
+		// Decoded by the sensor's model, a failed read keeps the old reading
+		for (size_t Idx = 0; Idx < NumReads; Idx++)
+		{
+			ppCaches[Reading[Idx]]->Update(Sensor::Decode(Responses[Idx]), Valid[Idx]);
+		}
+	}
+
+	for (size_t Idx = 0; Idx < NumCaches; Idx++)
+	{
+		pReadings[Idx] = ppCaches[Idx]->m_Reading;
+		NumFresh += ppCaches[Idx]->IsFresh(MaxAgeMs) ? 1 : 0;
+
+		xSemaphoreGive(ppCaches[Idx]->m_Lock);
+	}
+
+	return NumFresh;
+}
+
+// Caches of every sensor type in use
+template class SensorCache<DHT11>;
+template class SensorCache<DHT22>;
+
+/**
+ * @brief	Lists the cached readings, never reads a sensor
+ */
+static void SensorCommand(int Argc, char *pArgv[])
+{
+	(void) Argc;
+	(void) pArgv;
+
+	for (size_t Idx = 0; Idx < SensorCacheBase::s_NumCaches; Idx++)
+	{
+		SensorReading Reading = SensorCacheBase::s_pCaches[Idx]->Peek();
+
+		if (!Reading.Valid)
+		{
+			LOG_INFO(&s_SensorModule, "%d no reading yet", Idx);
+			continue;
+		}
+
+		uint32_t Temperature = (Reading.Temperature < 0) ? -Reading.Temperature : Reading.Temperature;
+
+		LOG_INFO(&s_SensorModule, "%d %s%lu.%luC %d.%d%%RH, %lums old", Idx, (Reading.Temperature < 0) ? "-" : "",
+				Temperature / 10, Temperature % 10, Reading.Humidity / 10, Reading.Humidity % 10,
+				osKernelGetTickCount() - Reading.Tick);
+	}
+}
+
+extern "C" {
+
+void SensorCache_Init(void)
+{
+	Command_Register("sensor", SensorCommand, "sensor");
+}
+
+}
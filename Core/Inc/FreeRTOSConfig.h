@@ -66,6 +66,7 @@
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
+#define configCHECK_FOR_STACK_OVERFLOW           2
 #define configUSE_RECURSIVE_MUTEXES              1
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
@@ -132,7 +133,14 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 /* Normal assert() semantics without relying on the provision of an assert.h
 header file. */
 /* USER CODE BEGIN 1 */
-#define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );}
+/* Failed asserts are logged and the log kept over the reset that follows */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #if defined(__cplusplus)
+  extern "C"
+  #endif
+  void Logger_AssertFailed(const char *File, int Line) __attribute__((noreturn));
+#endif
+#define configASSERT( x ) if ((x) == 0) {Logger_AssertFailed(__FILE__, __LINE__);}
 /* USER CODE END 1 */
 
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
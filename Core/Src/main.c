@@ -23,7 +23,8 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "dht11.h"
+#include "dht.h"
+#include "timebase.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -44,6 +45,7 @@
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
@@ -58,6 +60,7 @@ const osThreadAttr_t defaultTask_attributes = {
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_USART1_UART_Init(void);
 void StartDefaultTask(void *argument);
@@ -67,6 +70,8 @@ extern void App_Init(void);
 
 // Interrupt handlers
 extern void Logger_TransmitCompleteInterruptCallback(void);
+extern void Command_ReceiveCompleteInterruptCallback(void);
+extern void Command_ErrorInterruptCallback(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -105,6 +110,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
@@ -265,11 +271,29 @@ static void MX_USART2_UART_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN USART2_Init 2 */
-
+  // USART2 is the register level 1-Wire bus, retire the HAL handle so nothing can
+  // use it, and its interrupt, before OneWire takes the peripheral over
+  HAL_UART_DeInit(&huart2);
   /* USER CODE END USART2_Init 2 */
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel4_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -322,12 +346,11 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
 	switch (GPIO_Pin)
 	{
+	// DHT11 test sensors, each line is bound to its sensor's model here
 	case GPIO_PIN_0:
-		HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-		DHT11_InterruptHandler();
-		break;
 	case GPIO_PIN_1:
 		HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
+		DHT11_InterruptHandler(GPIO_Pin);
 		break;
 	case GPIO_PIN_13:
 		HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
@@ -340,9 +363,19 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 	switch ((uint32_t) huart->Instance)
 	{
 	case USART1_BASE:
+		Command_ReceiveCompleteInterruptCallback();
 		break;
-	case USART2_BASE:
-//		HAL_UART_Receive_IT(&huart1, rx_buff, 10);
+	case USART3_BASE:
+		break;
+	}
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	switch ((uint32_t) huart->Instance)
+	{
+	case USART1_BASE:
+		Command_ErrorInterruptCallback();
 		break;
 	case USART3_BASE:
 		break;
@@ -354,8 +387,7 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 	switch ((uint32_t) huart->Instance)
 	{
 	case USART1_BASE:
-		break;
-	case USART2_BASE:
+		Logger_TransmitCompleteInterruptCallback();
 		break;
 	case USART3_BASE:
 		break;
@@ -400,6 +432,9 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
+  if (htim->Instance == TIM1) {
+    Timebase_Update();
+  }
 
   /* USER CODE END Callback 1 */
 }
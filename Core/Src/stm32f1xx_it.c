@@ -22,6 +22,10 @@
 #include "stm32f1xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "edge_capture.h"
+#include "one_wire.h"
+#include "i2c_master.h"
+#include "adc_scan.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -36,7 +40,9 @@
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
-
+/* Hands a fault to the logger, LR still holds EXC_RETURN as nothing has been called yet */
+#define LOG_FAULT(Name)	\
+  do { uint32_t ExcReturn; __ASM volatile ("mov %0, lr" : "=r" (ExcReturn)); Logger_Fault(Name, ExcReturn); } while (0)
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
@@ -46,7 +52,7 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+extern void Logger_Fault(const char *Name, uint32_t ExcReturn) __attribute__((noreturn));
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -56,6 +62,7 @@
 
 /* External variables --------------------------------------------------------*/
 extern PCD_HandleTypeDef hpcd_USB_FS;
+extern DMA_HandleTypeDef hdma_usart1_tx;
 extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 extern TIM_HandleTypeDef htim1;
@@ -88,7 +95,7 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  LOG_FAULT("HardFault");
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -103,7 +110,7 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  LOG_FAULT("MemManage");
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -118,7 +125,7 @@ void MemManage_Handler(void)
 void BusFault_Handler(void)
 {
   /* USER CODE BEGIN BusFault_IRQn 0 */
-
+  LOG_FAULT("BusFault");
   /* USER CODE END BusFault_IRQn 0 */
   while (1)
   {
@@ -133,7 +140,7 @@ void BusFault_Handler(void)
 void UsageFault_Handler(void)
 {
   /* USER CODE BEGIN UsageFault_IRQn 0 */
-
+  LOG_FAULT("UsageFault");
   /* USER CODE END UsageFault_IRQn 0 */
   while (1)
   {
@@ -190,6 +197,20 @@ void EXTI1_IRQHandler(void)
   /* USER CODE END EXTI1_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 channel4 global interrupt.
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 1 */
+}
+
 /**
   * @brief This function handles USB low priority or CAN RX0 interrupts.
   */
@@ -262,4 +283,44 @@ void EXTI15_10_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA1 channel5 global interrupt, TIM2 CH1 edge capture.
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+  EdgeCapture_DmaInterruptHandler(DMA1_Channel5);
+}
+
+/**
+  * @brief This function handles DMA1 channel6 global interrupt, USART2 RX 1-Wire bus.
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+  OneWire_DmaInterruptHandler(DMA1_Channel6);
+}
+
+/**
+  * @brief This function handles I2C1 event interrupt, sensor bus.
+  */
+void I2C1_EV_IRQHandler(void)
+{
+  I2cMaster_EventInterruptHandler(I2C1);
+}
+
+/**
+  * @brief This function handles I2C1 error interrupt, sensor bus.
+  */
+void I2C1_ER_IRQHandler(void)
+{
+  I2cMaster_ErrorInterruptHandler(I2C1);
+}
+
+/**
+  * @brief This function handles DMA1 channel1 global interrupt, ADC1 thermistor scan.
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  AdcScan_DmaInterruptHandler(DMA1_Channel1);
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,119 @@
+/*
+ * adc_scan.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_ADC_SCAN_H_
+#define HARDWARE_INC_ADC_SCAN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f1xx_hal.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	AdcScan
+ * @brief	Oversampled analog inputs scanned in the background
+ * @note	A timer's update event triggers a scan of every channel, and DMA moves the
+ * 			samples into a circular buffer of two blocks of s_Oversampling scans.
+ * 			The half and full transfer interrupts each sum the block just filled into
+ * 			one 14-bit code per channel, so the CPU is interrupted once per block
+ * 			whatever the number of channels. Sixteen samples give two more bits than
+ * 			the ADC's twelve, the input's noise dithers them.
+ * 			Register level, the HAL ADC driver isn't part of the project.
+ *
+ * 			ADC1 is the only ADC with DMA, on DMA1 channel 1, which rules out TIM4
+ * 			capture. Its trigger is TIM3's update, TIM2 is taken by edge capture.
+ * 			Channels 0 to 7 are PA0 to PA7, 8 and 9 are PB0 and PB1, and 10 to 15
+ * 			are PC0 to PC5.
+ */
+class AdcScan
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	pAdc			ADC converting the channels, ADC1
+	 * @param	pDma			DMA channel serving the ADC
+	 * @param	DmaInterrupt	Interrupt of that DMA channel
+	 * @param	pTrigger		Timer whose update triggers a scan, TIM3
+	 * @param	pChannels		Channels in scan order, at most s_MaxChannels
+	 * @param	NumChannels		Number of channels
+	 */
+	AdcScan(ADC_TypeDef *pAdc, DMA_Channel_TypeDef *pDma, IRQn_Type DmaInterrupt, TIM_TypeDef *pTrigger,
+			const uint8_t *pChannels, size_t NumChannels);
+
+	/**
+	 * @brief	Calibrates the ADC, sets the channels' pins to analog and starts scanning
+	 * @retval	false	Too many channels, one without a pin, a trigger other than TIM3, or no room left to register another scan
+	 */
+	bool Init(void);
+
+	/**
+	 * @brief	Gets the codes of the last block, out of 16384
+	 * @param	pCodes		One per channel, in scan order
+	 * @retval	false		No block finished yet
+	 */
+	bool GetCodes(uint16_t *pCodes) const;
+
+	/**
+	 * @brief	Handles the interrupt of the scan's DMA channel
+	 */
+	void HandleDmaInterrupt(void);
+
+	static constexpr size_t s_MaxChannels = 8;
+
+	// Scans summed into a code, and the shift taking their sum to 14 bits
+	static constexpr uint32_t s_Oversampling = 16;
+	static constexpr uint32_t s_DecimationShift = 2;
+
+	// A code per channel this often, plenty for thermistors
+	static constexpr uint32_t s_BlockRateHz = 10;
+
+private:
+	/**
+	 * @brief	Sums a block of scans into codes, interrupt context
+	 */
+	void Decimate(const uint16_t *pBlock);
+
+	// Scans triggered per second
+	static constexpr uint32_t s_ScanRateHz = s_BlockRateHz * s_Oversampling;
+
+	// The trigger timer counts at this rate
+	static constexpr uint32_t s_TriggerTickRateHz = 1000000;
+
+	ADC_TypeDef *const m_pAdc;
+	DMA_Channel_TypeDef *const m_pDma;
+	const IRQn_Type m_DmaInterrupt;
+	TIM_TypeDef *const m_pTrigger;
+	const uint8_t *const m_pChannels;
+	const size_t m_NumChannels;
+
+	// Interrupt flags of the DMA channel are at this position in ISR and IFCR
+	const uint32_t m_DmaFlagShift;
+
+	// Two blocks, DMA fills one while the other is summed
+	uint16_t m_Samples[2 * s_Oversampling * s_MaxChannels];
+
+	// Codes of the last block, written by the interrupt
+	uint16_t m_Codes[s_MaxChannels];
+	volatile bool m_Valid;
+};
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Passes a DMA channel interrupt to the scan using it
+ */
+void AdcScan_DmaInterruptHandler(DMA_Channel_TypeDef *pDma);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_ADC_SCAN_H_ */
@@ -0,0 +1,470 @@
+/*
+ * dht.h
+ *
+ *  Created on: Sep 22, 2024
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_DHT_H_
+#define HARDWARE_INC_DHT_H_
+
+#include <stdbool.h>
+
+#include "stm32f1xx_hal.h"
+#include "stm32f1xx_hal_gpio.h"
+
+#include "logger.h"
+#include "edge_capture.h"
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+// Lowest level compiled into the driver, LogLevel::None removes all of its logging
+#define DHT_LOG_LEVEL		LogLevel::Debug
+
+#if defined(__cplusplus)
+/**
+ * @brief	Measurement decoded from a frame
+ */
+struct DhtMeasurement
+{
+	int16_t Temperature;	// Tenths of a degree C
+	uint16_t Humidity;		// Tenths of a % RH
+};
+
+/**
+ * @brief	DHT11 model: whole units in the first byte of each pair, tenths in the second
+ * @note	Models are the compile-time sensor concept DhtSensor is built on. Each one
+ * 			gives its names, start condition, sampling interval, pulse width windows
+ * 			and frame decode as constants, nothing about a model is looked up at runtime.
+ */
+struct DHT11Model
+{
+	// Names of the model's service task and timer
+	static constexpr const char *s_Name = "DHT11";
+
+	// Micro pulls line low for at least 18ms to start transmission, one tick is lost
+	// to the timer's granularity
+	static constexpr uint32_t s_StartConditionMs = 19;
+
+	// Shortest time between two reads of a sensor, it can't sample faster
+	static constexpr uint32_t s_MinIntervalMs = 1000;
+
+	// Pulse width windows in us, bounds excluded. Each bit is prefixed with a 50us
+	// low, a zero is a 26-28us high and a one a 70us high, all with a 4us margin.
+	static constexpr uint32_t s_BitStartMinUs = 46;
+	static constexpr uint32_t s_BitStartMaxUs = 54;
+	static constexpr uint32_t s_ZeroMinUs = 22;
+	static constexpr uint32_t s_ZeroMaxUs = 32;
+	static constexpr uint32_t s_OneMinUs = 60;
+	static constexpr uint32_t s_OneMaxUs = 80;
+
+	/**
+	 * @brief	Decodes the four data bytes of a checked frame
+	 */
+	static constexpr DhtMeasurement Decode(const uint8_t *pFrame)
+	{
+		return {
+			(int16_t)(((int8_t)pFrame[2] * 10) + pFrame[3]),
+			(uint16_t)((pFrame[0] * 10) + pFrame[1])
+		};
+	}
+};
+
+/**
+ * @brief	DHT22/AM2302 model: 16-bit tenths, temperature in sign and magnitude
+ */
+struct DHT22Model
+{
+	static constexpr const char *s_Name = "DHT22";
+
+	// Start condition is 0.8-20ms, at least one whole tick
+	static constexpr uint32_t s_StartConditionMs = 2;
+
+	static constexpr uint32_t s_MinIntervalMs = 2000;
+
+	// Bit start low is 48-55us, a zero 22-30us and a one 68-75us, with a 4us margin
+	static constexpr uint32_t s_BitStartMinUs = 44;
+	static constexpr uint32_t s_BitStartMaxUs = 59;
+	static constexpr uint32_t s_ZeroMinUs = 18;
+	static constexpr uint32_t s_ZeroMaxUs = 34;
+	static constexpr uint32_t s_OneMinUs = 64;
+	static constexpr uint32_t s_OneMaxUs = 79;
+
+	static constexpr DhtMeasurement Decode(const uint8_t *pFrame)
+	{
+		return {
+			(int16_t)(((pFrame[2] & 0x80) ? -1 : 1) * (((pFrame[2] & 0x7F) << 8) | pFrame[3])),
+			(uint16_t)((pFrame[0] << 8) | pFrame[1])
+		};
+	}
+};
+
+/**
+ * @class	DhtSensor
+ * @brief	DHT family driver, generic over the sensor model
+ * @note	Reads are queued to the model's service task, which runs every sensor's state
+ * 			machine. Nothing waits on the line: the start condition and frame timeouts
+ * 			are a one-shot timer and the frame is received by interrupts.
+ *
+ * 			Queued reads are run in rounds: every sensor at the head of the queue with
+ * 			a receiver of its own (an EXTI line or an edge capture) sends its start
+ * 			condition and receives its frame at the same time as the others, so a
+ * 			round of N sensors takes about as long as a read of one.
+ *
+ * 			Everything model specific is a constant of the Model, the edge decode is
+ * 			compiled per model and per receiver. Each model used has its own service
+ * 			task and queue, the interrupt channels are shared between them.
+ */
+template <typename Model>
+class DhtSensor
+{
+public:
+	/**
+	 * @brief	Constructor for a sensor on an EXTI pin
+	 * @note	Edges are timestamped in the pin's interrupt, it must be set to trigger
+	 * 			on the rising edge and is set to trigger on the falling edge too
+	 * @param	Port		Pointer to port register block
+	 * @param	Pin			Pin number
+	 * @param	Interrupt	Interrupt channel number
+	 */
+	DhtSensor(GPIO_TypeDef *pPort, uint32_t Pin, IRQn_Type Interrupt);
+
+	/**
+	 * @brief	Constructor for a sensor on a timer channel 1 pin
+	 * @note	Edges are timestamped by the timer and moved by DMA, see EdgeCapture
+	 * @param	Port		Pointer to port register block
+	 * @param	Pin			Pin number
+	 * @param	pCapture	Initialised capture of the pin's timer
+	 */
+	DhtSensor(GPIO_TypeDef *pPort, uint32_t Pin, EdgeCapture *pCapture);
+
+	/**
+	 * @brief	Destructor
+	 */
+	~DhtSensor();
+
+	enum class State
+	{
+		Idle,			// No read queued
+		Waiting,		// Queued, or sending the start condition
+		Reading,		// Receiving the frame
+		ReadComplete	// Frame received, waiting for the service task to parse it
+	};
+
+	/**
+	 * @brief	Reads full data packet from the sensor
+	 * @note	Sleeps on a task notification until the service task has the result,
+	 * 			the CPU is free for the whole read
+	 * @param	pRxBuff	Pointer to read buffer, five bytes
+	 * @retval	true	Response is valid
+	 */
+	bool ReadBlocking(uint8_t *pRxBuff);
+
+	/**
+	 * @brief	Reads several sensors at once, see ReadBlocking
+	 * @note	Sensors on different receivers are read in the same round
+	 * @param	ppSensors	Sensors to read, at most s_QueueLength
+	 * @param	pRxBuffs	Read buffer for each sensor
+	 * @param	pValid		Set for each sensor whose response is valid
+	 * @retval	Number of valid responses
+	 */
+	static size_t ReadBlocking(DhtSensor *const *ppSensors, size_t NumSensors, uint8_t (*pRxBuffs)[5],
+			bool *pValid);
+
+	/**
+	 * @brief	Starts a non-blocking read
+	 * @param	Callback	Called from the service task with the five byte response,
+	 * 						NULL if the read failed
+	 * @retval	true		Read started
+	 * @retval	false		Driver busy, read not started
+	 */
+	bool ReadNonBlocking(void (*Callback)(uint8_t *));
+
+	/**
+	 * @brief	Decodes a valid response, see the Model
+	 */
+	static constexpr DhtMeasurement Decode(const uint8_t *pRxBuff)
+	{
+		return Model::Decode(pRxBuff);
+	}
+
+	/**
+	 * @brief	Handles pin interrupt during a non-blocking read
+	 * @param	Time		Time of interrupt occurrence
+	 */
+	void HandlePinInterrupt(uint32_t Time);
+
+	/**
+	 * @brief	Passes an EXTI line interrupt to the model's reader on the line, if any
+	 * @retval	false		No reader of the model on the line
+	 */
+	static bool HandleLineInterrupt(uint32_t Line, uint32_t Time);
+
+	/**
+	 * @brief	Gets the state of the sensor's read
+	 */
+	enum State GetState(void);
+
+	/**
+	 * @brief	Creates the model's service task, before any read
+	 */
+	static void Init(void);
+
+	/**
+	 * @brief	Service task, runs the state machines of the active readers
+	 */
+	static void ServiceTask(void *pArgument);
+
+	// Shortest time between two reads of a sensor
+	static constexpr uint32_t s_MinIntervalMs = Model::s_MinIntervalMs;
+
+	// Read queue
+	static constexpr size_t s_QueueLength = 8;
+	static QueueHandle_t s_Queue;
+
+	// Readers of the current round, empty slots are null
+	static constexpr size_t s_MaxActiveReaders = 4;
+	static DhtSensor *s_pActiveReaders[s_MaxActiveReaders];
+
+	// Receiving reader of each EXTI line, interrupts look their reader up here
+	static DhtSensor *volatile s_pLineReaders[16];
+
+	// Phase of the current round, all of its readers go through it together, and
+	// the tick it started at. A stale timer expiry is ignored by the phase's age.
+	static State s_RoundPhase;
+	static uint32_t s_PhaseStartTick;
+
+	// Service task and the one-shot timer timing its phases
+	static osThreadId_t s_ServiceTask;
+	static osTimerId_t s_PhaseTimer;
+
+	// Service task notification bits
+	static constexpr uint32_t s_RequestFlag = 0x01;	// A read was queued
+	static constexpr uint32_t s_TimerFlag = 0x02;	// The phase timer expired
+	static constexpr uint32_t s_FrameFlag = 0x04;	// The active reader received its frame
+
+private:
+	// Shared by every sensor, records carry the interrupt channel to tell them apart
+	static constexpr FilteredLoggerModule<DHT_LOG_LEVEL> s_LoggerModule{LogModuleId::DHT};
+
+	volatile enum State m_State;
+
+	// Number of data bits in a full transmission packet
+	static constexpr size_t s_NumBitsPerTransmission = 40;
+
+	// Edges of a frame, starting with the falling edge of the response: the response
+	// low and high, then a low and a high for each bit ended by the next edge. They
+	// are decoded as they arrive and not kept, captures are kept by the EdgeCapture.
+	static constexpr size_t s_FrameEdges = 3 + (2 * s_NumBitsPerTransmission);
+	volatile uint8_t m_NumEdges;
+
+	static_assert(s_FrameEdges <= EdgeCapture::s_MaxEdges, "Frame must fit an edge capture");
+	static_assert((Model::s_ZeroMaxUs <= Model::s_OneMinUs) && (Model::s_ZeroMinUs < Model::s_ZeroMaxUs) &&
+			(Model::s_OneMinUs < Model::s_OneMaxUs), "Zero and one windows must not overlap");
+
+	/**
+	 * @brief	Pulse width windows in edge time ticks, bounds excluded
+	 */
+	struct BitTiming
+	{
+		uint32_t BitStartMin;
+		uint32_t BitStartMax;
+		uint32_t ZeroMin;
+		uint32_t ZeroMax;
+		uint32_t OneMin;
+		uint32_t OneMax;
+	};
+
+	// Edge time rate and wrap of each receiver
+	static constexpr uint32_t s_InterruptTicksPerUs = 72;
+	static constexpr uint32_t s_InterruptTickMask = UINT32_MAX;
+	static constexpr uint32_t s_CaptureTicksPerUs = EdgeCapture::s_TickRateHz / 1000000;
+	static constexpr uint32_t s_CaptureTickMask = EdgeCapture::s_TickMask;
+
+	/**
+	 * @brief	Converts the model's pulse width windows to ticks of a receiver
+	 */
+	static constexpr BitTiming MakeTiming(uint32_t TicksPerUs)
+	{
+		return {
+			Model::s_BitStartMinUs * TicksPerUs, Model::s_BitStartMaxUs * TicksPerUs,
+			Model::s_ZeroMinUs * TicksPerUs, Model::s_ZeroMaxUs * TicksPerUs,
+			Model::s_OneMinUs * TicksPerUs, Model::s_OneMaxUs * TicksPerUs
+		};
+	}
+
+	// Frame decoded so far: the first 32 bits, the checksum byte, and pulses outside
+	// their window. Bits are shifted in as their high pulse ends.
+	uint32_t m_LastEdge;
+	uint32_t m_Data;
+	uint8_t m_Checksum;
+	uint8_t m_Errors;
+
+	// Diagnostics window, the first pulse outside its window: the edge ending it and
+	// its width in ticks, saturated at 16 bits
+	uint8_t m_FirstErrorEdge;
+	uint16_t m_FirstErrorWidth;
+
+	// Timer capture of the pin, null if edges are timed in its interrupt
+	EdgeCapture *const m_pCapture;
+
+	// Task waiting in ReadBlocking, given a notification once the result is in
+	TaskHandle_t m_WaitingTask;
+
+	// Response of the last read and whether it's valid, copied out by ReadBlocking
+	uint8_t m_Response[5];
+	bool m_Valid;
+
+	// Non-blocking read callback
+	void  (*m_Callback)(uint8_t *);
+
+	// GPIO information, the interrupt is the capture's DMA interrupt with an edge
+	// capture. Either way it tells sensors apart in the logs.
+	GPIO_TypeDef *const m_Port;
+	const uint32_t m_Pin;
+	const IRQn_Type m_InterruptChannel;
+
+	// Longest wait for a frame: response, 40 ones and the end condition, with margin
+	static constexpr uint32_t s_FrameTimeoutMs = 10;
+
+	// Longest wait in ReadBlocking: a start condition and frame for every queued read
+	static constexpr uint32_t s_ReadTimeoutMs = (s_QueueLength + 1) *
+			(Model::s_StartConditionMs + s_FrameTimeoutMs + 1);
+
+
+	/**
+	 * @brief	Queues a read to the service task
+	 * @param	WaitingTask	Task to notify with the result, or null
+	 * @param	Callback	Callback to pass the result to if there is no task, or null
+	 * @retval	false		A read of the sensor is already queued, or the queue is full
+	 */
+	bool Queue(TaskHandle_t WaitingTask, void (*Callback)(uint8_t *));
+
+	/**
+	 * @brief	Pulls the line low for the start condition
+	 */
+	void StartTransmission(void);
+
+	/**
+	 * @brief	Releases the line and starts receiving the frame
+	 */
+	void StartReception(void);
+
+	/**
+	 * @brief	Decodes a frame edge as it arrives, interrupt context
+	 * @note	Compiled for each receiver, its windows are constants
+	 * @param	Edge	Index of the edge in the frame
+	 * @param	Time	Time of the edge
+	 */
+	template <uint32_t TicksPerUs, uint32_t TickMask>
+	void DecodeEdge(uint32_t Edge, uint32_t Time);
+
+	/**
+	 * @brief	Counts a pulse outside its window, keeping the first for diagnostics
+	 */
+	void CountError(uint32_t Edge, uint32_t Width);
+
+	/**
+	 * @brief	Marks the frame received and wakes the service task, interrupt context
+	 */
+	void FrameReceived(void);
+
+	/**
+	 * @brief	Parses the frame, or fails a timed out one, and hands the result over
+	 * @param	Received	The whole frame was received
+	 */
+	void TransmissionComplete(bool Received);
+
+	/**
+	 * @brief	Wakes the service task once a captured frame is complete
+	 */
+	static void CaptureComplete(void *pContext);
+
+	/**
+	 * @brief	Claims the sensor's interrupt channel for a round, from any model
+	 * @retval	false		Another reader is using the channel
+	 */
+	bool ClaimChannel(void);
+
+	/**
+	 * @brief	Releases the channel claimed for the round
+	 */
+	void ReleaseChannel(void);
+
+	/**
+	 * @brief	Starts a round with the reads at the head of the queue
+	 */
+	static void StartRound(void);
+
+	/**
+	 * @brief	Drives the line high, the idle state between reads
+	 */
+	void ResetPin(void);
+
+	/**
+	 * @brief	Resets the driver
+	 */
+	void Reset(void);
+
+	/**
+	 * @brief	Unpacks the decoded frame and checks it
+	 * @param	pRxBuff		Pointer to buffer to populate
+	 * @retval	true		Response is valid
+	 */
+	bool ParseResponse(uint8_t *pRxBuff);
+};
+
+typedef DhtSensor<DHT11Model> DHT11;
+typedef DhtSensor<DHT22Model> DHT22;
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Initialises the DHT11 service task, before any DHT11 read
+ */
+void DHT11_Init(void);
+
+/**
+ * @brief	Initialises the DHT22 service task, before any DHT22 read
+ */
+void DHT22_Init(void);
+
+/**
+ * @brief	Holds DHT rounds off while flash is programmed or erased
+ * @note	Programming stalls every fetch from flash, interrupts included, which
+ * 			would throw out the edge timestamps of a frame being received. Rounds
+ * 			queued meanwhile start once the flash is released.
+ * @retval	false	A round of some model is in flight, try again later
+ */
+bool DHT_ClaimFlash(void);
+
+/**
+ * @brief	Lets DHT rounds start again, see DHT_ClaimFlash
+ */
+void DHT_ReleaseFlash(void);
+
+/**
+ * @brief	Handles pin interrupt during a non-blocking DHT11 read
+ * @note	Each EXTI line is bound to one model where its interrupt is dispatched,
+ * 			so the sampling path never tries other models
+ * @param	GPIO_Pin	Pin mask of the interrupting EXTI line
+ */
+void DHT11_InterruptHandler(uint16_t GPIO_Pin);
+
+/**
+ * @brief	Handles pin interrupt during a non-blocking DHT22 read, see DHT11_InterruptHandler
+ */
+void DHT22_InterruptHandler(uint16_t GPIO_Pin);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_DHT_H_ */
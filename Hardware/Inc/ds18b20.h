@@ -0,0 +1,88 @@
+/*
+ * ds18b20.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_DS18B20_H_
+#define HARDWARE_INC_DS18B20_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "one_wire.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	DS18B20
+ * @brief	Every DS18B20 probe on a 1-Wire bus
+ * @note	All probes convert at once, so reading the bus costs one conversion time,
+ * 			slept through, plus a scratchpad read per probe. A read is ~14ms of bus
+ * 			time moved by DMA, the CPU only sets it up and decodes it.
+ * 			Probes must be externally powered, the USART can't drive the strong
+ * 			pull-up parasite power needs during a conversion.
+ */
+class DS18B20
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	pBus	Initialised bus the probes are on
+	 */
+	DS18B20(OneWire *pBus);
+
+	/**
+	 * @brief	Searches the bus for probes, replacing those found before
+	 * @retval	Number of probes found
+	 */
+	size_t Discover(void);
+
+	/**
+	 * @brief	Converts on every probe at once and reads them all
+	 * @note	Task context, sleeps through the conversion
+	 * @param	pTemperatures	Tenths of a degree C of each probe found by Discover
+	 * @param	pValid			Set for each probe read with a good CRC
+	 * @retval	Number of valid readings
+	 */
+	size_t ReadAll(int16_t *pTemperatures, bool *pValid);
+
+	/**
+	 * @brief	Gets the number of probes found by Discover
+	 */
+	size_t GetNumProbes(void) const;
+
+	static constexpr size_t s_MaxProbes = 8;
+
+private:
+	/**
+	 * @brief	Reads a probe's scratchpad and decodes its temperature
+	 * @retval	false	No answer or a bad CRC
+	 */
+	bool ReadProbe(size_t Probe, int16_t *pTemperature);
+
+	static constexpr uint8_t s_FamilyCode = 0x28;
+
+	// Function commands
+	static constexpr uint8_t s_ConvertT = 0x44;
+	static constexpr uint8_t s_ReadScratchpad = 0xBE;
+
+	// Longest conversion, at the default 12-bit resolution
+	static constexpr uint32_t s_ConversionTimeMs = 750;
+
+	// Scratchpad bytes, the CRC last
+	static constexpr size_t s_ScratchpadLength = 9;
+
+	// Configuration register, only its resolution bits can change
+	static constexpr size_t s_ConfigurationByte = 4;
+	static constexpr uint8_t s_ConfigurationMask = 0x9F;
+	static constexpr uint8_t s_ConfigurationFixed = 0x1F;
+
+	OneWire *const m_pBus;
+
+	uint64_t m_Roms[s_MaxProbes];
+	size_t m_NumProbes;
+};
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_DS18B20_H_ */
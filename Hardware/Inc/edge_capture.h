@@ -0,0 +1,116 @@
+/*
+ * edge_capture.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_EDGE_CAPTURE_H_
+#define HARDWARE_INC_EDGE_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f1xx_hal.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	EdgeCapture
+ * @brief	Timestamps both edges of a timer channel 1 input straight into memory
+ * @note	Channel 1 captures the TI1 edge detector, so every edge of the pin is
+ * 			captured whatever its direction, and its DMA request moves each 16-bit
+ * 			capture into the capture's own edge buffer. A whole frame costs one
+ * 			transfer complete interrupt.
+ * 			Register level, the HAL TIM driver isn't set up for any of the timers.
+ *
+ * 			TIM2 CH1 is PA0 on DMA1 channel 5, TIM3 CH1 is PA6 on DMA1 channel 6 and
+ * 			TIM4 CH1 is PB6 on DMA1 channel 1.
+ */
+class EdgeCapture
+{
+public:
+	/**
+	 * @brief	Called from the DMA interrupt once the buffer is full
+	 */
+	typedef void (*Callback)(void *pContext);
+
+	/**
+	 * @brief	Constructor
+	 * @param	pTimer			Timer whose channel 1 input is captured
+	 * @param	pDma			DMA channel serving the timer's channel 1 requests
+	 * @param	DmaInterrupt	Interrupt of that DMA channel
+	 */
+	EdgeCapture(TIM_TypeDef *pTimer, DMA_Channel_TypeDef *pDma, IRQn_Type DmaInterrupt);
+
+	/**
+	 * @brief	Starts the timer counting, the pin must be an input
+	 * @retval	false	No room left to register another capture
+	 */
+	bool Init(void);
+
+	/**
+	 * @brief	Captures the next NumEdges edges, at most s_MaxEdges
+	 * @param	Done		Called from the interrupt when they are all captured
+	 * @retval	false		A capture is already running
+	 */
+	bool Start(size_t NumEdges, Callback Done, void *pContext);
+
+	/**
+	 * @brief	Gets the capture values of the last capture, in timer ticks
+	 */
+	const uint16_t *GetEdges(void) const;
+
+	/**
+	 * @brief	Stops the running capture, if any
+	 * @retval	Edges captured so far
+	 */
+	size_t Stop(void);
+
+	/**
+	 * @brief	Gets the interrupt of the capture's DMA channel
+	 */
+	IRQn_Type GetDmaInterrupt(void) const;
+
+	/**
+	 * @brief	Handles the interrupt of the capture's DMA channel
+	 */
+	void HandleDmaInterrupt(void);
+
+	// Capture values count at this rate and wrap at 16 bits
+	static constexpr uint32_t s_TickRateHz = 1000000;
+	static constexpr uint32_t s_TickMask = 0xFFFF;
+
+	// Longest capture, a DHT11 frame
+	static constexpr size_t s_MaxEdges = 84;
+
+private:
+	TIM_TypeDef *const m_pTimer;
+	DMA_Channel_TypeDef *const m_pDma;
+	const IRQn_Type m_DmaInterrupt;
+
+	// Interrupt flags of the DMA channel are at this position in ISR and IFCR
+	const uint32_t m_DmaFlagShift;
+
+	uint16_t m_Edges[s_MaxEdges];
+	size_t m_NumEdges;
+	volatile bool m_Running;
+
+	Callback m_Done;
+	void *m_pContext;
+};
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Passes a DMA channel interrupt to the capture using it
+ */
+void EdgeCapture_DmaInterruptHandler(DMA_Channel_TypeDef *pDma);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_EDGE_CAPTURE_H_ */
@@ -0,0 +1,197 @@
+/*
+ * i2c_master.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_I2C_MASTER_H_
+#define HARDWARE_INC_I2C_MASTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f1xx_hal.h"
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#if defined(__cplusplus)
+/**
+ * @brief	Outcome of an I2C transaction
+ */
+enum class I2cResult
+{
+	Ok,
+	Queued,		// Waiting for, or running on, the bus
+	Nack,		// The device didn't acknowledge its address or a byte
+	BusError,	// Misplaced start or stop, lost arbitration or overrun, the bus was recovered
+	Timeout		// Not finished in time, SCL held low too long, the bus was recovered
+};
+
+/**
+ * @brief	I2C transaction, a write then a read after a repeated start
+ * @note	Owned by the submitting driver, it must stay untouched until Done runs
+ */
+struct I2cTransaction
+{
+	uint8_t Address;				// 7-bit device address
+	const uint8_t *pWrite;
+	size_t NumWrite;
+	uint8_t *pRead;
+	size_t NumRead;
+
+	// Called from the bus's service task once the transaction is over, or null
+	void (*Done)(I2cTransaction *pTransaction);
+	void *pContext;
+
+	volatile I2cResult Result;
+};
+
+/**
+ * @class	I2cMaster
+ * @brief	I2C master running queued transactions from any number of drivers
+ * @note	Drivers submit transactions and get a callback, nothing but the bus's
+ * 			service task waits on the bus. Transactions are driven by the event and
+ * 			error interrupts, a byte an interrupt. The service task sleeps until a
+ * 			transaction finishes or times out, and recovers a stuck bus by clocking
+ * 			out the slave holding SDA before resetting the peripheral.
+ *
+ * 			Register level, the HAL I2C driver isn't part of the project. The DMA
+ * 			channels of I2C1 are USART2's, taken by the 1-Wire bus, and sensor
+ * 			transactions are a few bytes each.
+ *
+ * 			I2C1 is PB6/PB7, or PB8/PB9 remapped.
+ */
+class I2cMaster
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	pI2c			I2C peripheral
+	 * @param	EventInterrupt	Its event interrupt
+	 * @param	ErrorInterrupt	Its error interrupt
+	 * @param	pPort			Port of the SCL and SDA pins
+	 * @param	SclPin			SCL pin number, I2C1 is remapped if it's 8
+	 * @param	SdaPin			SDA pin number
+	 */
+	I2cMaster(I2C_TypeDef *pI2c, IRQn_Type EventInterrupt, IRQn_Type ErrorInterrupt, GPIO_TypeDef *pPort,
+			uint32_t SclPin, uint32_t SdaPin);
+
+	/**
+	 * @brief	Sets up the peripheral and pins and creates the service task
+	 * @retval	false	No room left to register another bus
+	 */
+	bool Init(void);
+
+	/**
+	 * @brief	Queues a transaction, never blocks
+	 * @note	Any task or timer callback, not interrupts
+	 * @retval	false	The queue is full, or the transaction is already queued
+	 */
+	bool Submit(I2cTransaction *pTransaction);
+
+	/**
+	 * @brief	Handles the event interrupt
+	 */
+	void HandleEventInterrupt(void);
+
+	/**
+	 * @brief	Handles the error interrupt
+	 */
+	void HandleErrorInterrupt(void);
+
+	// Standard mode, long wires in the enclosure
+	static constexpr uint32_t s_ClockHz = 100000;
+
+	static constexpr size_t s_QueueLength = 8;
+
+	// Longest transaction, a few bytes with room for clock stretching
+	static constexpr uint32_t s_TransactionTimeoutMs = 10;
+
+private:
+	/**
+	 * @brief	Service task, runs the queued transactions in order
+	 */
+	static void ServiceTask(void *pArgument);
+
+	/**
+	 * @brief	Runs a transaction, sleeping until it's over
+	 */
+	I2cResult Execute(I2cTransaction *pTransaction);
+
+	/**
+	 * @brief	Ends the running transaction and wakes the service task, interrupt context
+	 */
+	void Finish(I2cResult Result);
+
+	/**
+	 * @brief	Waits for the last stop to go out and the bus to free
+	 * @retval	false	Still busy after a few ticks
+	 */
+	bool WaitIdle(void);
+
+	/**
+	 * @brief	Frees a stuck bus and resets the peripheral
+	 * @note	Clocks SCL by hand until the slave releases SDA, then sends a stop
+	 */
+	void Recover(void);
+
+	/**
+	 * @brief	Sets the clock and enables the peripheral, after a reset
+	 */
+	void Configure(void);
+
+	/**
+	 * @brief	Sets the SCL and SDA pins to the peripheral or to open drain outputs
+	 */
+	void ConfigurePins(bool Peripheral);
+
+	I2C_TypeDef *const m_pI2c;
+	const IRQn_Type m_EventInterrupt;
+	const IRQn_Type m_ErrorInterrupt;
+	GPIO_TypeDef *const m_pPort;
+	const uint32_t m_SclPin;
+	const uint32_t m_SdaPin;
+
+	// Running transaction, null between transactions, and its progress
+	I2cTransaction *volatile m_pCurrent;
+	size_t m_Index;
+	bool m_Reading;
+
+	// Repeated start requested after the write, waiting for its start bit
+	bool m_RestartPending;
+
+	// Heap is too small to spare for the service task, allocated with the bus
+	StaticTask_t m_TaskControlBlock;
+	uint32_t m_TaskStack[192];
+	osThreadId_t m_ServiceTask;
+
+	StaticQueue_t m_QueueControlBlock;
+	uint8_t m_QueueStorage[s_QueueLength * sizeof(I2cTransaction *)];
+	QueueHandle_t m_Queue;
+};
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Passes an I2C event interrupt to the bus using the peripheral
+ */
+void I2cMaster_EventInterruptHandler(I2C_TypeDef *pI2c);
+
+/**
+ * @brief	Passes an I2C error interrupt to the bus using the peripheral
+ */
+void I2cMaster_ErrorInterruptHandler(I2C_TypeDef *pI2c);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_I2C_MASTER_H_ */
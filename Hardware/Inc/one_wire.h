@@ -0,0 +1,167 @@
+/*
+ * one_wire.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_ONE_WIRE_H_
+#define HARDWARE_INC_ONE_WIRE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32f1xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	OneWire
+ * @brief	1-Wire bus master on a half-duplex USART
+ * @note	Every time slot is one UART byte on the USART's TX pin, open drain with
+ * 			the bus pull-up. At 115200 baud 0x00 is a write 0 slot, and 0xFF is a
+ * 			write 1 or read slot that reads back 0xFF only if no device held the
+ * 			line low. At 9600 baud 0xF0 is a reset pulse, read back changed by a
+ * 			presence pulse.
+ *
+ * 			A transfer expands bytes into slots in the bus's slot buffer, and DMA
+ * 			sends and receives them in place. The calling task sleeps until the
+ * 			receive transfer completes, one interrupt per transfer. Transfers are
+ * 			made by the task holding the bus lock.
+ * 			Register level, the USART's HAL handle must be de-initialised first.
+ *
+ * 			USART2 is PA2, with TX on DMA1 channel 7 and RX on DMA1 channel 6.
+ */
+class OneWire
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	pUsart			USART driving the bus
+	 * @param	pTxDma			DMA channel serving the USART's TX requests
+	 * @param	pRxDma			DMA channel serving the USART's RX requests
+	 * @param	RxDmaInterrupt	Interrupt of the RX DMA channel
+	 * @param	pPort			Port of the USART's TX pin
+	 * @param	Pin				Pin number of the USART's TX pin
+	 */
+	OneWire(USART_TypeDef *pUsart, DMA_Channel_TypeDef *pTxDma, DMA_Channel_TypeDef *pRxDma,
+			IRQn_Type RxDmaInterrupt, GPIO_TypeDef *pPort, uint32_t Pin);
+
+	/**
+	 * @brief	Switches the USART to half duplex and its pin to open drain
+	 * @retval	false	No room left to register another bus
+	 */
+	bool Init(void);
+
+	/**
+	 * @brief	Takes the bus for a sequence of transfers, task context
+	 */
+	void Lock(void);
+
+	/**
+	 * @brief	Releases the bus
+	 */
+	void Unlock(void);
+
+	/**
+	 * @brief	Sends a reset pulse
+	 * @retval	true	A device answered with a presence pulse
+	 */
+	bool Reset(void);
+
+	/**
+	 * @brief	Writes bytes then reads bytes, least significant bit first, in one transfer
+	 * @note	At most s_MaxTransferBytes in total
+	 * @param	pRead	Filled with the bytes read, may be null if NumRead is zero
+	 * @retval	false	The transfer didn't complete
+	 */
+	bool Transfer(const uint8_t *pWrite, size_t NumWrite, uint8_t *pRead, size_t NumRead);
+
+	/**
+	 * @brief	Finds the ROM codes of the devices on the bus
+	 * @param	pRoms		Filled with the ROM codes, family code in the low byte
+	 * @retval	Number of devices found, at most MaxRoms
+	 */
+	size_t Search(uint64_t *pRoms, size_t MaxRoms);
+
+	/**
+	 * @brief	Calculates the Maxim CRC-8 of a block, zero over a block ending in its CRC
+	 */
+	static uint8_t Crc8(const uint8_t *pData, size_t Length);
+
+	/**
+	 * @brief	Handles the interrupt of the RX DMA channel
+	 */
+	void HandleDmaInterrupt(void);
+
+	// ROM commands
+	static constexpr uint8_t s_SearchRom = 0xF0;
+	static constexpr uint8_t s_MatchRom = 0x55;
+	static constexpr uint8_t s_SkipRom = 0xCC;
+
+	// Longest transfer: a match ROM and a function command, then a nine byte read
+	static constexpr size_t s_MaxTransferBytes = 20;
+
+private:
+	/**
+	 * @brief	Sends slots and reads them back in place, sleeping until done
+	 * @param	Baud	Slot rate, s_SlotBaud or s_ResetBaud
+	 */
+	bool Exchange(size_t NumSlots, uint32_t Baud);
+
+	/**
+	 * @brief	Sets the baud rate, between transfers
+	 */
+	void SetBaud(uint32_t Baud);
+
+	// One slot per byte at this rate, 87us. A 0 holds the line low for 78us, a 1 or
+	// read for one start bit, 8.7us, and the read is sampled by the UART at ~13us.
+	static constexpr uint32_t s_SlotBaud = 115200;
+
+	// Reset pulse byte and rate, 0xF0 holds the line low for five bits, 520us
+	static constexpr uint32_t s_ResetBaud = 9600;
+	static constexpr uint8_t s_ResetSlot = 0xF0;
+
+	static constexpr uint8_t s_ZeroSlot = 0x00;
+	static constexpr uint8_t s_OneSlot = 0xFF;
+
+	static constexpr size_t s_MaxSlots = 8 * s_MaxTransferBytes;
+
+	USART_TypeDef *const m_pUsart;
+	DMA_Channel_TypeDef *const m_pTxDma;
+	DMA_Channel_TypeDef *const m_pRxDma;
+	const IRQn_Type m_RxDmaInterrupt;
+	GPIO_TypeDef *const m_pPort;
+	const uint32_t m_Pin;
+
+	// Interrupt flags of the RX DMA channel are at this position in ISR and IFCR
+	const uint32_t m_RxDmaFlagShift;
+
+	// Slots of the running transfer, sent and received in place
+	uint8_t m_Slots[s_MaxSlots];
+	uint32_t m_Baud;
+
+	// Bus owner, and the transfer complete signal the owner sleeps on
+	StaticSemaphore_t m_LockControlBlock;
+	SemaphoreHandle_t m_Lock;
+	StaticSemaphore_t m_DoneControlBlock;
+	SemaphoreHandle_t m_Done;
+};
+#endif /* __cplusplus */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Passes a DMA channel interrupt to the bus using it
+ */
+void OneWire_DmaInterruptHandler(DMA_Channel_TypeDef *pDma);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_ONE_WIRE_H_ */
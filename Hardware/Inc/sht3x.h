@@ -0,0 +1,128 @@
+/*
+ * sht3x.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef HARDWARE_INC_SHT3X_H_
+#define HARDWARE_INC_SHT3X_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "i2c_master.h"
+
+#include "cmsis_os2.h"
+
+#include "FreeRTOS.h"
+#include "timers.h"
+
+#if defined(__cplusplus)
+/**
+ * @class	SHT3x
+ * @brief	SHT3x humidity and temperature sensor in periodic mode
+ * @note	The sensor measures by itself once a second. A software timer submits a
+ * 			fetch of the latest measurement to the bus and the bus's service task
+ * 			decodes it, so no task ever waits on the sensor or the bus. Readers get
+ * 			the last measurement decoded.
+ * 			A fetch before the first measurement is NACKed. After a bus error or
+ * 			timeout, or a NACKed start, a break takes the sensor out of periodic
+ * 			mode in case it didn't reset, and the start command is sent again. A
+ * 			sensor in periodic mode only accepts a fetch or a break.
+ */
+class SHT3x
+{
+public:
+	/**
+	 * @brief	Constructor
+	 * @param	pBus		Initialised bus the sensor is on
+	 * @param	Address		0x44, or 0x45 with ADDR high
+	 */
+	SHT3x(I2cMaster *pBus, uint8_t Address = 0x44);
+
+	/**
+	 * @brief	Starts periodic measurements and the fetch timer
+	 * @retval	false	The timer couldn't be started
+	 */
+	bool Start(void);
+
+	/**
+	 * @brief	Gets the last measurement, never blocks
+	 * @param	pTemperature	Tenths of a degree C
+	 * @param	pHumidity		Tenths of a percent relative humidity
+	 * @param	pTick			Kernel tick the measurement was fetched at, may be null
+	 * @retval	false	Nothing measured yet, or the sensor stopped measuring and is
+	 * 					being restarted
+	 */
+	bool GetLatest(int16_t *pTemperature, uint16_t *pHumidity, uint32_t *pTick) const;
+
+	// Matches the one measurement a second the sensor is started at
+	static constexpr uint32_t s_FetchPeriodMs = 1000;
+
+private:
+	/**
+	 * @brief	Submits the next transaction, timer service task
+	 */
+	static void FetchTimer(void *pArgument);
+
+	/**
+	 * @brief	Start command done, bus service task
+	 */
+	static void StartDone(I2cTransaction *pTransaction);
+
+	/**
+	 * @brief	Break done, the start command can follow, bus service task
+	 */
+	static void BreakDone(I2cTransaction *pTransaction);
+
+	/**
+	 * @brief	Fetch done, checks and decodes the measurement, bus service task
+	 */
+	static void FetchDone(I2cTransaction *pTransaction);
+
+	/**
+	 * @brief	Calculates the Sensirion CRC-8 of a word
+	 */
+	static uint8_t Crc8(const uint8_t *pData, size_t Length);
+
+	// Periodic mode, one measurement a second with high repeatability
+	static constexpr uint8_t s_StartPeriodic[] = { 0x21, 0x30 };
+	static constexpr uint8_t s_FetchData[] = { 0xE0, 0x00 };
+	static constexpr uint8_t s_Break[] = { 0x30, 0x93 };
+
+	// Temperature then humidity, each a big endian word and its CRC
+	static constexpr size_t s_MeasurementLength = 6;
+
+	// Fetches NACKed in a row before the sensor is taken to have left periodic mode,
+	// e.g. reset by a brown-out into single shot mode, which NACKs every fetch
+	static constexpr uint8_t s_MaxNacks = 3;
+
+	I2cMaster *const m_pBus;
+
+	I2cTransaction m_StartTransaction;
+	I2cTransaction m_FetchTransaction;
+	I2cTransaction m_BreakTransaction;
+	uint8_t m_Measurement[s_MeasurementLength];
+
+	// Periodic mode was acknowledged, fetches are sent rather than start commands
+	volatile bool m_Running;
+
+	// Periodic mode may be running unseen, a break goes before the next start command
+	volatile bool m_NeedsBreak;
+
+	// Fetches NACKed since the last one acknowledged, bus service task
+	uint8_t m_Nacks;
+
+	// Last measurement, written by the bus's service task
+	int16_t m_Temperature;
+	uint16_t m_Humidity;
+	uint32_t m_Tick;
+	bool m_Valid;
+
+	StaticTimer_t m_TimerControlBlock;
+	osTimerId_t m_FetchTimer;
+};
+#endif /* __cplusplus */
+
+#endif /* HARDWARE_INC_SHT3X_H_ */
@@ -0,0 +1,252 @@
+/*
+ * adc_scan.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "adc_scan.h"
+
+// Scans to route DMA interrupts to, identified by their DMA channel
+static constexpr size_t s_MaxScans = 1;
+static AdcScan *s_pScans[s_MaxScans];
+static DMA_Channel_TypeDef *s_pScanDmas[s_MaxScans];
+static size_t s_NumScans = 0;
+
+// Must be able to use the FreeRTOS FromISR API
+static constexpr uint32_t s_DmaInterruptPriority = 5;
+
+// Longest sample time, 239.5 ADC clocks, for every channel. At 12MHz a conversion
+// is 21us, short against a scan period, and the divider's source impedance can be high.
+static constexpr uint32_t s_SampleTimes1 = 0x00FFFFFF;
+static constexpr uint32_t s_SampleTimes2 = 0x3FFFFFFF;
+
+// Channels above are the internal temperature sensor and reference, no pins
+static constexpr uint8_t s_MaxPinChannel = 15;
+
+// Regular group external trigger, TIM3 TRGO
+static constexpr uint32_t s_Tim3TrgoTrigger = ADC_CR2_EXTSEL_2;
+
+/**
+ * @brief	Gets the position of a DMA1 channel's flags in ISR and IFCR
+ */
+static uint32_t DmaFlagShift(DMA_Channel_TypeDef *pDma)
+{
+	uint32_t Stride = (uintptr_t)DMA1_Channel2 - (uintptr_t)DMA1_Channel1;
+	return 4 * (((uintptr_t)pDma - (uintptr_t)DMA1_Channel1) / Stride);
+}
+
+/**
+ * @brief	Gets the clock the APB1 timers count, twice PCLK1 unless APB1 is undivided
+ */
+static uint32_t TimerClockHz(void)
+{
+	uint32_t Pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) ? Pclk1 : (2 * Pclk1);
+}
+
+/**
+ * @brief	Sets a channel's pin to analog input
+ */
+static void SetAnalog(uint8_t Channel)
+{
+	GPIO_TypeDef *pPort = GPIOA;
+	uint32_t Pin = Channel;
+
+	if ((Channel == 8) || (Channel == 9))
+	{
+		pPort = GPIOB;
+		Pin = Channel - 8;
+	}
+	else if (Channel >= 10)
+	{
+		pPort = GPIOC;
+		Pin = Channel - 10;
+	}
+
+	// Mode and configuration both zero
+	pPort->CRL &= ~(0x0FUL << (4 * Pin));
+}
+
+AdcScan::AdcScan(ADC_TypeDef *pAdc, DMA_Channel_TypeDef *pDma, IRQn_Type DmaInterrupt, TIM_TypeDef *pTrigger,
+		const uint8_t *pChannels, size_t NumChannels) :
+		m_pAdc(pAdc),
+		m_pDma(pDma),
+		m_DmaInterrupt(DmaInterrupt),
+		m_pTrigger(pTrigger),
+		m_pChannels(pChannels),
+		m_NumChannels(NumChannels),
+		m_DmaFlagShift(DmaFlagShift(pDma)),
+		m_Samples{0},
+		m_Codes{0},
+		m_Valid(false)
+{
+}
+
+bool AdcScan::Init(void)
+{
+	if ((m_NumChannels == 0) || (m_NumChannels > s_MaxChannels) || (m_pTrigger != TIM3) ||
+		(s_NumScans >= s_MaxScans))
+	{
+		return false;
+	}
+
+	for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+	{
+		if (m_pChannels[Idx] > s_MaxPinChannel)
+		{
+			return false;
+		}
+	}
+
+	s_pScans[s_NumScans] = this;
+	s_pScanDmas[s_NumScans] = m_pDma;
+	s_NumScans++;
+
+	for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+	{
+		SetAnalog(m_pChannels[Idx]);
+	}
+
+	// At most 14MHz, PCLK2 / 6 is 12MHz
+	__HAL_RCC_ADC_CONFIG(RCC_ADCPCLK2_DIV6);
+	__HAL_RCC_ADC1_CLK_ENABLE();
+	__HAL_RCC_TIM3_CLK_ENABLE();
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	// Power up, then calibrate once it's stable, a microsecond
+	m_pAdc->CR2 = ADC_CR2_ADON;
+	HAL_Delay(1);
+	m_pAdc->CR2 |= ADC_CR2_RSTCAL;
+
+	while (m_pAdc->CR2 & ADC_CR2_RSTCAL)
+	{
+	}
+
+	m_pAdc->CR2 |= ADC_CR2_CAL;
+
+	while (m_pAdc->CR2 & ADC_CR2_CAL)
+	{
+	}
+
+	// Scan sequence, five bits per channel, six in SQR3 and six in SQR2
+	m_pAdc->SMPR1 = s_SampleTimes1;
+	m_pAdc->SMPR2 = s_SampleTimes2;
+	m_pAdc->SQR1 = (m_NumChannels - 1) << ADC_SQR1_L_Pos;
+	m_pAdc->SQR2 = 0;
+	m_pAdc->SQR3 = 0;
+
+	for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+	{
+		if (Idx < 6)
+		{
+			m_pAdc->SQR3 |= (uint32_t)m_pChannels[Idx] << (5 * Idx);
+		}
+		else
+		{
+			m_pAdc->SQR2 |= (uint32_t)m_pChannels[Idx] << (5 * (Idx - 6));
+		}
+	}
+
+	// Circular, so the buffer refills forever without the CPU
+	m_pDma->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_DmaFlagShift;
+	m_pDma->CPAR = (uint32_t)(uintptr_t)&m_pAdc->DR;
+	m_pDma->CMAR = (uint32_t)(uintptr_t)m_Samples;
+	m_pDma->CNDTR = 2 * s_Oversampling * m_NumChannels;
+	m_pDma->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE |
+			DMA_CCR_TEIE | DMA_CCR_EN;
+
+	HAL_NVIC_SetPriority(m_DmaInterrupt, s_DmaInterruptPriority, 0);
+	HAL_NVIC_EnableIRQ(m_DmaInterrupt);
+
+	// Written with ADON already set but other bits changing, this doesn't start a conversion
+	m_pAdc->CR1 = ADC_CR1_SCAN;
+	m_pAdc->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_EXTTRIG | s_Tim3TrgoTrigger;
+
+	// Update events as TRGO, one a scan
+	m_pTrigger->CR1 = 0;
+	m_pTrigger->CR2 = TIM_CR2_MMS_1;
+	m_pTrigger->PSC = (TimerClockHz() / s_TriggerTickRateHz) - 1;
+	m_pTrigger->ARR = (s_TriggerTickRateHz / s_ScanRateHz) - 1;
+	m_pTrigger->EGR = TIM_EGR_UG;
+	m_pTrigger->CR1 = TIM_CR1_CEN;
+
+	return true;
+}
+
+bool AdcScan::GetCodes(uint16_t *pCodes) const
+{
+	HAL_NVIC_DisableIRQ(m_DmaInterrupt);
+	bool Valid = m_Valid;
+
+	for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+	{
+		pCodes[Idx] = m_Codes[Idx];
+	}
+
+	HAL_NVIC_EnableIRQ(m_DmaInterrupt);
+
+	return Valid;
+}
+
+void AdcScan::Decimate(const uint16_t *pBlock)
+{
+	uint32_t Sums[s_MaxChannels] = { 0 };
+
+	// Samples are interleaved, a scan of every channel after another
+	for (size_t Scan = 0; Scan < s_Oversampling; Scan++)
+	{
+		for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+		{
+			Sums[Idx] += *pBlock++;
+		}
+	}
+
+	for (size_t Idx = 0; Idx < m_NumChannels; Idx++)
+	{
+		m_Codes[Idx] = (uint16_t)(Sums[Idx] >> s_DecimationShift);
+	}
+
+	m_Valid = true;
+}
+
+void AdcScan::HandleDmaInterrupt(void)
+{
+	uint32_t Flags = DMA1->ISR >> m_DmaFlagShift;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_DmaFlagShift;
+
+	// A transfer error disables the channel, the codes go stale and the readers see it
+	if (Flags & DMA_ISR_TEIF1)
+	{
+		m_Valid = false;
+		return;
+	}
+
+	// The block just filled, DMA is already writing the other one
+	if (Flags & DMA_ISR_HTIF1)
+	{
+		Decimate(&m_Samples[0]);
+	}
+
+	if (Flags & DMA_ISR_TCIF1)
+	{
+		Decimate(&m_Samples[s_Oversampling * m_NumChannels]);
+	}
+}
+
+extern "C" {
+
+void AdcScan_DmaInterruptHandler(DMA_Channel_TypeDef *pDma)
+{
+	for (size_t Idx = 0; Idx < s_NumScans; Idx++)
+	{
+		if (s_pScanDmas[Idx] == pDma)
+		{
+			s_pScans[Idx]->HandleDmaInterrupt();
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,765 @@
+/*
+ * dht.cpp
+ *
+ *  Created on: Sep 22, 2024
+ *      Author: mhamz
+ */
+
+#include "dht.h"
+
+#include <string.h>
+
+#define PIN_INPUT(Port, Pin)	\
+	{\
+		volatile uint32_t *Reg = (volatile uint32_t *)(Pin < 8 ? &Port->CRL : &Port->CRH);	\
+		uint32_t Pos =  4 * (Pin < 8 ? Pin : Pin - 8);	\
+		*Reg &= (~(0x0F << Pos));	\
+		*Reg |= 0x04 << Pos;	\
+	}
+#define PIN_OUTPUT(Port, Pin)	\
+	{\
+		volatile uint32_t *Reg = (volatile uint32_t *)(Pin < 8 ? &Port->CRL : &Port->CRH);	\
+		uint32_t Pos =  4 * (Pin < 8 ? Pin : Pin - 8);	\
+		*Reg &= (~(0x0F << Pos));	\
+		*Reg |= 0x01 << Pos;	\
+	}
+
+#define PIN_HIGH(Port, Pin)					(Port->ODR |= (1 << Pin))
+#define PIN_LOW(Port, Pin)					(Port->ODR &= ~(1 << Pin))
+
+#define PIN_READ(Port, Pin)					(Port->IDR & (1 << Pin))
+
+#define INTERRUPT_ENABLE(Channel)			HAL_NVIC_EnableIRQ(Channel)
+#define INTERRUPT_DISABLE(Channel)			HAL_NVIC_DisableIRQ(Channel)
+
+#define TIMER_CURRENT						DWT->CYCCNT
+
+// Per-read logs are limited to a few per burst of reads, then one per period
+static constexpr uint16_t s_ReadLogBurst = 4;
+static constexpr uint32_t s_ReadLogPeriodMs = 10000;
+
+// Interrupt channels in use by a round, of any model. Sensors of different models
+// may share an EXTI interrupt, their rounds take turns on it.
+static uint64_t s_ClaimedChannels = 0;
+
+// Rounds in flight, of any model, and whether flash programming holds new ones off
+static uint32_t s_ActiveRounds = 0;
+static bool s_FlashClaimed = false;
+
+/**
+ * @brief	Counts a round in flight unless flash is being programmed
+ * @retval	false	Flash holds rounds off
+ */
+static bool BeginRound(void)
+{
+	osKernelLock();
+	bool Begun = !s_FlashClaimed;
+
+	if (Begun)
+	{
+		s_ActiveRounds++;
+	}
+
+	osKernelUnlock();
+
+	return Begun;
+}
+
+/**
+ * @brief	Counts a round finished, see BeginRound
+ */
+static void EndRound(void)
+{
+	osKernelLock();
+	s_ActiveRounds--;
+	osKernelUnlock();
+}
+
+template <typename Model>
+QueueHandle_t DhtSensor<Model>::s_Queue = nullptr;
+template <typename Model>
+DhtSensor<Model> *DhtSensor<Model>::s_pActiveReaders[s_MaxActiveReaders] = { nullptr };
+template <typename Model>
+DhtSensor<Model> *volatile DhtSensor<Model>::s_pLineReaders[16] = { nullptr };
+template <typename Model>
+typename DhtSensor<Model>::State DhtSensor<Model>::s_RoundPhase = DhtSensor<Model>::State::Idle;
+template <typename Model>
+uint32_t DhtSensor<Model>::s_PhaseStartTick = 0;
+template <typename Model>
+osThreadId_t DhtSensor<Model>::s_ServiceTask = nullptr;
+template <typename Model>
+osTimerId_t DhtSensor<Model>::s_PhaseTimer = nullptr;
+
+template <typename Model>
+DhtSensor<Model>::DhtSensor(GPIO_TypeDef *pPort, uint32_t Pin, IRQn_Type Interrupt) :
+		m_State(State::Idle),
+		m_NumEdges(0),
+		m_LastEdge(0),
+		m_Data(0),
+		m_Checksum(0),
+		m_Errors(0),
+		m_FirstErrorEdge(0),
+		m_FirstErrorWidth(0),
+		m_pCapture(nullptr),
+		m_WaitingTask(nullptr),
+		m_Response{0},
+		m_Valid(false),
+		m_Callback(nullptr),
+		m_Port(pPort),
+		m_Pin(Pin),
+		m_InterruptChannel(Interrupt)
+{
+	ResetPin();
+
+	// Both edges of the frame are timestamped
+	EXTI->FTSR |= (1 << m_Pin);
+
+	LOG_DEBUG(&s_LoggerModule, "%d Created", m_InterruptChannel);
+}
+
+template <typename Model>
+DhtSensor<Model>::DhtSensor(GPIO_TypeDef *pPort, uint32_t Pin, EdgeCapture *pCapture) :
+		m_State(State::Idle),
+		m_NumEdges(0),
+		m_LastEdge(0),
+		m_Data(0),
+		m_Checksum(0),
+		m_Errors(0),
+		m_FirstErrorEdge(0),
+		m_FirstErrorWidth(0),
+		m_pCapture(pCapture),
+		m_WaitingTask(nullptr),
+		m_Response{0},
+		m_Valid(false),
+		m_Callback(nullptr),
+		m_Port(pPort),
+		m_Pin(Pin),
+		m_InterruptChannel(pCapture->GetDmaInterrupt())
+{
+	ResetPin();
+
+	LOG_DEBUG(&s_LoggerModule, "%d Created with edge capture", m_InterruptChannel);
+}
+
+template <typename Model>
+DhtSensor<Model>::~DhtSensor()
+{
+	LOG_DEBUG(&s_LoggerModule, "%d Destroyed", m_InterruptChannel);
+}
+
+template <typename Model>
+bool DhtSensor<Model>::ReadBlocking(uint8_t *pRxBuff)
+{
+	DhtSensor *pSensor = this;
+	bool Valid = false;
+
+	ReadBlocking(&pSensor, 1, (uint8_t (*)[5])pRxBuff, &Valid);
+
+	return Valid;
+}
+
+template <typename Model>
+size_t DhtSensor<Model>::ReadBlocking(DhtSensor *const *ppSensors, size_t NumSensors, uint8_t (*pRxBuffs)[5],
+		bool *pValid)
+{
+	TaskHandle_t CurrentTask = xTaskGetCurrentTaskHandle();
+	size_t NumQueued = 0, NumDone = 0, NumValid = 0;
+	bool Queued[s_QueueLength] = { false };
+
+	NumSensors = (NumSensors < s_QueueLength) ? NumSensors : s_QueueLength;
+
+	// Drop the results of reads that timed out earlier
+	ulTaskNotifyTake(pdTRUE, 0);
+
+	for (size_t Idx = 0; Idx < NumSensors; Idx++)
+	{
+		LOG_LIMITED_AT(&s_LoggerModule, LogLevel::Debug, s_ReadLogBurst, s_ReadLogPeriodMs, "%d Blocking read",
+				ppSensors[Idx]->m_InterruptChannel);
+
+		pValid[Idx] = false;
+		Queued[Idx] = ppSensors[Idx]->Queue(CurrentTask, nullptr);
+		NumQueued += Queued[Idx] ? 1 : 0;
+	}
+
+	// Each read gives the task a notification as it finishes, in any order
+	uint32_t StartTick = osKernelGetTickCount();
+	uint32_t Timeout = pdMS_TO_TICKS(s_ReadTimeoutMs);
+
+	while (NumDone < NumQueued)
+	{
+		uint32_t Elapsed = osKernelGetTickCount() - StartTick;
+
+		if ((Elapsed >= Timeout) || (ulTaskNotifyTake(pdFALSE, Timeout - Elapsed) == 0))
+		{
+			break;
+		}
+
+		NumDone++;
+	}
+
+	for (size_t Idx = 0; Idx < NumSensors; Idx++)
+	{
+		if (!Queued[Idx])
+		{
+			continue;
+		}
+
+		DhtSensor *pSensor = ppSensors[Idx];
+
+		// A read still running finishes without us, the service task notifies under the lock
+		osKernelLock();
+		bool Done = (pSensor->m_WaitingTask == nullptr);
+		pSensor->m_WaitingTask = nullptr;
+		osKernelUnlock();
+
+		if (!Done)
+		{
+			LOG_WARN(&s_LoggerModule, "%d No result in time", pSensor->m_InterruptChannel);
+			continue;
+		}
+
+		memcpy(pRxBuffs[Idx], pSensor->m_Response, sizeof(pSensor->m_Response));
+		pValid[Idx] = pSensor->m_Valid;
+		NumValid += pValid[Idx] ? 1 : 0;
+	}
+
+	return NumValid;
+}
+
+template <typename Model>
+bool DhtSensor<Model>::ReadNonBlocking(void (*Callback)(uint8_t *))
+{
+	LOG_LIMITED_AT(&s_LoggerModule, LogLevel::Debug, s_ReadLogBurst, s_ReadLogPeriodMs, "%d Non-blocking read",
+			m_InterruptChannel);
+
+	return Queue(nullptr, Callback);
+}
+
+template <typename Model>
+bool DhtSensor<Model>::Queue(TaskHandle_t WaitingTask, void (*Callback)(uint8_t *))
+{
+	// Claim the sensor, a read already queued keeps its own caller
+	osKernelLock();
+	bool Claimed = (m_State == State::Idle);
+
+	if (Claimed)
+	{
+		m_State = State::Waiting;
+	}
+
+	osKernelUnlock();
+
+	if (!Claimed)
+	{
+		return false;
+	}
+
+	m_WaitingTask = WaitingTask;
+	m_Callback = Callback;
+
+	DhtSensor *pSensor = this;
+
+	if (xQueueSendToBack(s_Queue, &pSensor, 0) != pdTRUE)
+	{
+		m_WaitingTask = nullptr;
+		m_Callback = nullptr;
+		m_State = State::Idle;
+		return false;
+	}
+
+	xTaskNotify((TaskHandle_t)s_ServiceTask, s_RequestFlag, eSetBits);
+	return true;
+}
+
+template <typename Model>
+void DhtSensor<Model>::HandlePinInterrupt(uint32_t Time)
+{
+	if (m_State == State::Reading)
+	{
+		DecodeEdge<s_InterruptTicksPerUs, s_InterruptTickMask>(m_NumEdges, Time);
+		m_NumEdges++;
+
+		// The frame is decoded the moment its last edge lands
+		if (m_NumEdges >= s_FrameEdges)
+		{
+			INTERRUPT_DISABLE(m_InterruptChannel);
+			s_pLineReaders[m_Pin] = nullptr;
+			FrameReceived();
+		}
+	}
+}
+
+template <typename Model>
+void DhtSensor<Model>::CountError(uint32_t Edge, uint32_t Width)
+{
+	if (m_Errors++ == 0)
+	{
+		m_FirstErrorEdge = (uint8_t)Edge;
+		m_FirstErrorWidth = (Width < UINT16_MAX) ? (uint16_t)Width : UINT16_MAX;
+	}
+}
+
+template <typename Model>
+bool DhtSensor<Model>::HandleLineInterrupt(uint32_t Line, uint32_t Time)
+{
+	DhtSensor *pReader = s_pLineReaders[Line];
+
+	if (pReader == nullptr)
+	{
+		return false;
+	}
+
+	pReader->HandlePinInterrupt(Time);
+	return true;
+}
+
+template <typename Model>
+template <uint32_t TicksPerUs, uint32_t TickMask>
+void DhtSensor<Model>::DecodeEdge(uint32_t Edge, uint32_t Time)
+{
+	static constexpr BitTiming s_Timing = MakeTiming(TicksPerUs);
+
+	uint32_t Width = (Time - m_LastEdge) & TickMask;
+	m_LastEdge = Time;
+
+	// Edges 0-2 are the response, from 3 on odd edges end a bit's low and even ones its high
+	if (Edge < 3)
+	{
+		return;
+	}
+
+	if (Edge & 1)
+	{
+		if ((Width <= s_Timing.BitStartMin) || (Width >= s_Timing.BitStartMax))
+		{
+			CountError(Edge, Width);
+		}
+
+		return;
+	}
+
+	uint32_t Bit = (Width > s_Timing.OneMin);
+
+	if (Bit ? (Width >= s_Timing.OneMax) : ((Width <= s_Timing.ZeroMin) || (Width >= s_Timing.ZeroMax)))
+	{
+		CountError(Edge, Width);
+	}
+
+	// Most significant first, the first 32 bits end at edge 66
+	if (Edge < 4 + (2 * 32))
+	{
+		m_Data = (m_Data << 1) | Bit;
+	}
+	else
+	{
+		m_Checksum = (uint8_t)((m_Checksum << 1) | Bit);
+	}
+}
+
+template <typename Model>
+typename DhtSensor<Model>::State DhtSensor<Model>::GetState(void)
+{
+	return m_State;
+}
+
+template <typename Model>
+void DhtSensor<Model>::FrameReceived(void)
+{
+	BaseType_t Woken = pdFALSE;
+
+	m_State = State::ReadComplete;
+	LOG_ISR_LIMITED_AT(&s_LoggerModule, LogLevel::Debug, s_ReadLogBurst, s_ReadLogPeriodMs,
+			"%d Read complete, %d edges", m_InterruptChannel, m_NumEdges);
+
+	xTaskNotifyFromISR((TaskHandle_t)s_ServiceTask, s_FrameFlag, eSetBits, &Woken);
+	portYIELD_FROM_ISR(Woken);
+}
+
+template <typename Model>
+void DhtSensor<Model>::TransmissionComplete(bool Received)
+{
+	if (Received)
+	{
+		m_Valid = ParseResponse(m_Response);
+	}
+	else
+	{
+		LOG_WARN(&s_LoggerModule, "%d Timed out after %d edges", m_InterruptChannel, m_NumEdges);
+		memset(m_Response, 0, sizeof(m_Response));
+		m_Valid = false;
+	}
+
+	// Taken before the reset, the sensor may be queued again from the callback
+	void (*Callback)(uint8_t *) = m_Callback;
+	bool Valid = m_Valid;
+
+	// The waiting task clears its handle under the lock if it gave up on the read
+	osKernelLock();
+	TaskHandle_t WaitingTask = m_WaitingTask;
+	m_WaitingTask = nullptr;
+
+	if (WaitingTask != nullptr)
+	{
+		xTaskNotifyGive(WaitingTask);
+	}
+
+	osKernelUnlock();
+
+	Reset();
+
+	if ((WaitingTask == nullptr) && (Callback != nullptr))
+	{
+		Callback(Valid ? m_Response : nullptr);
+	}
+}
+
+template <typename Model>
+bool DhtSensor<Model>::ParseResponse(uint8_t *pRxBuff)
+{
+	pRxBuff[0] = (uint8_t)(m_Data >> 24);
+	pRxBuff[1] = (uint8_t)(m_Data >> 16);
+	pRxBuff[2] = (uint8_t)(m_Data >> 8);
+	pRxBuff[3] = (uint8_t)m_Data;
+	pRxBuff[4] = m_Checksum;
+
+	uint8_t Checksum = pRxBuff[0] + pRxBuff[1] + pRxBuff[2] + pRxBuff[3];
+
+	LOG_LIMITED_AT(&s_LoggerModule, LogLevel::Debug, s_ReadLogBurst, s_ReadLogPeriodMs,
+			"%d Response %4d %4d %4d %4d %4d Check %d Errors %d", m_InterruptChannel,
+			pRxBuff[0], pRxBuff[1], pRxBuff[2], pRxBuff[3], pRxBuff[4],
+			Checksum, m_Errors);
+
+	if (m_Errors > 0)
+	{
+		LOG_DEBUG(&s_LoggerModule, "%d First bad pulse ends at edge %d, %d ticks", m_InterruptChannel,
+				m_FirstErrorEdge, m_FirstErrorWidth);
+	}
+
+	return ((m_Errors == 0) && (Checksum == pRxBuff[4]));
+}
+
+template <typename Model>
+void DhtSensor<Model>::StartTransmission(void)
+{
+	LOG_TRACE(&s_LoggerModule, "%d Starting transmission", m_InterruptChannel);
+	m_NumEdges = 0;
+	m_Data = 0;
+	m_Checksum = 0;
+	m_Errors = 0;
+	m_FirstErrorEdge = 0;
+	m_FirstErrorWidth = 0;
+	ResetPin();
+	PIN_LOW(m_Port, m_Pin);
+}
+
+template <typename Model>
+void DhtSensor<Model>::StartReception(void)
+{
+	// The sensor takes 20-40us to answer the released line, plenty to arm the receiver
+	m_State = State::Reading;
+	PIN_INPUT(m_Port, m_Pin);
+
+	if (m_pCapture != nullptr)
+	{
+		m_pCapture->Start(s_FrameEdges, CaptureComplete, this);
+	}
+	else
+	{
+		// The release's own rising edge must not count
+		s_pLineReaders[m_Pin] = this;
+		EXTI->PR = (1 << m_Pin);
+		NVIC_ClearPendingIRQ(m_InterruptChannel);
+		INTERRUPT_ENABLE(m_InterruptChannel);
+	}
+}
+
+template <typename Model>
+void DhtSensor<Model>::CaptureComplete(void *pContext)
+{
+	DhtSensor *pSensor = (DhtSensor *)pContext;
+
+	// The whole frame landed at once, decode it before waking the service task
+	const uint16_t *pEdges = pSensor->m_pCapture->GetEdges();
+
+	for (uint32_t Edge = 0; Edge < s_FrameEdges; Edge++)
+	{
+		pSensor->DecodeEdge<s_CaptureTicksPerUs, s_CaptureTickMask>(Edge, pEdges[Edge]);
+	}
+
+	pSensor->m_NumEdges = s_FrameEdges;
+	pSensor->FrameReceived();
+}
+
+template <typename Model>
+bool DhtSensor<Model>::ClaimChannel(void)
+{
+	// One channel per reader, EXTI lines sharing an interrupt are disabled together
+	uint64_t Channel = (uint64_t)1 << m_InterruptChannel;
+
+	osKernelLock();
+	bool Claimed = !(s_ClaimedChannels & Channel);
+
+	if (Claimed)
+	{
+		s_ClaimedChannels |= Channel;
+	}
+
+	osKernelUnlock();
+
+	return Claimed;
+}
+
+template <typename Model>
+void DhtSensor<Model>::ReleaseChannel(void)
+{
+	osKernelLock();
+	s_ClaimedChannels &= ~((uint64_t)1 << m_InterruptChannel);
+	osKernelUnlock();
+}
+
+template <typename Model>
+void DhtSensor<Model>::StartRound(void)
+{
+	size_t NumReaders = 0;
+	DhtSensor *pNext = nullptr;
+
+	// Flash is being programmed, look again next tick
+	if (!BeginRound())
+	{
+		if (uxQueueMessagesWaiting(s_Queue) > 0)
+		{
+			osTimerStart(s_PhaseTimer, 1);
+		}
+
+		return;
+	}
+
+	// Take reads off the head of the queue in order until one would share a receiver
+	while ((NumReaders < s_MaxActiveReaders) && (xQueuePeek(s_Queue, &pNext, 0) == pdTRUE) &&
+		pNext->ClaimChannel())
+	{
+		xQueueReceive(s_Queue, &pNext, 0);
+		s_pActiveReaders[NumReaders++] = pNext;
+		pNext->StartTransmission();
+	}
+
+	if (NumReaders > 0)
+	{
+		LOG_TRACE(&s_LoggerModule, "Round of %d", NumReaders);
+
+		s_RoundPhase = State::Waiting;
+		s_PhaseStartTick = osKernelGetTickCount();
+		osTimerStart(s_PhaseTimer, pdMS_TO_TICKS(Model::s_StartConditionMs));
+		return;
+	}
+
+	EndRound();
+
+	if (uxQueueMessagesWaiting(s_Queue) > 0)
+	{
+		// The head's channel is in another model's round, look again next tick
+		osTimerStart(s_PhaseTimer, 1);
+	}
+}
+
+template <typename Model>
+void DhtSensor<Model>::ResetPin(void)
+{
+	// The capture's DMA interrupt stays enabled, it only fires while capturing
+	if (m_pCapture == nullptr)
+	{
+		INTERRUPT_DISABLE(m_InterruptChannel);
+
+		if (s_pLineReaders[m_Pin] == this)
+		{
+			s_pLineReaders[m_Pin] = nullptr;
+		}
+	}
+	else
+	{
+		m_pCapture->Stop();
+	}
+
+	PIN_OUTPUT(m_Port, m_Pin);
+	PIN_HIGH(m_Port, m_Pin);
+}
+
+template <typename Model>
+void DhtSensor<Model>::Reset(void)
+{
+	ResetPin();
+	ReleaseChannel();
+	m_Callback = nullptr;
+	m_WaitingTask = nullptr;
+	m_NumEdges = 0;
+	m_State = State::Idle;
+	LOG_TRACE(&s_LoggerModule, "%d Reset", m_InterruptChannel);
+}
+
+template <typename Model>
+void DhtSensor<Model>::ServiceTask(void *pArgument)
+{
+	(void) pArgument;
+
+	while (1)
+	{
+		uint32_t Flags = 0;
+		xTaskNotifyWait(0, UINT32_MAX, &Flags, portMAX_DELAY);
+
+		uint32_t Elapsed = osKernelGetTickCount() - s_PhaseStartTick;
+		bool StartReceiving = (Flags & s_TimerFlag) && (s_RoundPhase == State::Waiting) &&
+				(Elapsed >= pdMS_TO_TICKS(Model::s_StartConditionMs));
+		bool TimedOut = (Flags & s_TimerFlag) && (s_RoundPhase == State::Reading) &&
+				(Elapsed >= pdMS_TO_TICKS(s_FrameTimeoutMs));
+		size_t NumActive = 0;
+
+		// Release every line of the round at once, their frames arrive together
+		if (StartReceiving)
+		{
+			s_RoundPhase = State::Reading;
+			s_PhaseStartTick = osKernelGetTickCount();
+
+			for (size_t Idx = 0; Idx < s_MaxActiveReaders; Idx++)
+			{
+				if (s_pActiveReaders[Idx] != nullptr)
+				{
+					s_pActiveReaders[Idx]->StartReception();
+				}
+			}
+
+			osTimerStart(s_PhaseTimer, pdMS_TO_TICKS(s_FrameTimeoutMs));
+		}
+
+		for (size_t Idx = 0; Idx < s_MaxActiveReaders; Idx++)
+		{
+			DhtSensor *pReader = s_pActiveReaders[Idx];
+
+			if (pReader == nullptr)
+			{
+				continue;
+			}
+
+			if (pReader->GetState() == State::ReadComplete)
+			{
+				s_pActiveReaders[Idx] = nullptr;
+				pReader->TransmissionComplete(true);
+			}
+			else if (TimedOut)
+			{
+				if (pReader->m_pCapture != nullptr)
+				{
+					pReader->m_NumEdges = pReader->m_pCapture->Stop();
+				}
+
+				s_pActiveReaders[Idx] = nullptr;
+				pReader->TransmissionComplete(false);
+			}
+			else
+			{
+				NumActive++;
+			}
+		}
+
+		// Start the next round once the last one is done, the queue is only read here
+		if (NumActive == 0)
+		{
+			if (s_RoundPhase != State::Idle)
+			{
+				osTimerStop(s_PhaseTimer);
+				s_RoundPhase = State::Idle;
+				EndRound();
+			}
+
+			StartRound();
+		}
+	}
+}
+
+/**
+ * @brief	Phase timer expiry of a model, runs in the timer task
+ */
+template <typename Model>
+static void PhaseTimerExpired(void *pArgument)
+{
+	(void) pArgument;
+	xTaskNotify((TaskHandle_t)DhtSensor<Model>::s_ServiceTask, DhtSensor<Model>::s_TimerFlag, eSetBits);
+}
+
+template <typename Model>
+void DhtSensor<Model>::Init(void)
+{
+	// Heap is too small to spare for another task, allocate statically
+	static StaticTask_t TaskControlBlock;
+	static uint32_t TaskStack[192];
+	static StaticTimer_t TimerControlBlock;
+	static StaticQueue_t QueueControlBlock;
+	static uint8_t QueueStorage[s_QueueLength * sizeof(DhtSensor *)];
+
+	const osThreadAttr_t TaskAttributes = {
+		.name = Model::s_Name,
+		.cb_mem = &TaskControlBlock,
+		.cb_size = sizeof(TaskControlBlock),
+		.stack_mem = TaskStack,
+		.stack_size = sizeof(TaskStack),
+		.priority = (osPriority_t) osPriorityAboveNormal,
+	};
+
+	const osTimerAttr_t TimerAttributes = {
+		.name = Model::s_Name,
+		.cb_mem = &TimerControlBlock,
+		.cb_size = sizeof(TimerControlBlock),
+	};
+
+	s_Queue = xQueueCreateStatic(s_QueueLength, sizeof(DhtSensor *), QueueStorage, &QueueControlBlock);
+	s_PhaseTimer = osTimerNew(PhaseTimerExpired<Model>, osTimerOnce, nullptr, &TimerAttributes);
+	s_ServiceTask = osThreadNew(ServiceTask, nullptr, &TaskAttributes);
+}
+
+// Every model's code is compiled here. Nothing references a model the application
+// doesn't read, its init and interrupt handler included, so section garbage
+// collection (CubeIDE's default) drops it when linking.
+template class DhtSensor<DHT11Model>;
+template class DhtSensor<DHT22Model>;
+
+extern "C" {
+
+void DHT11_Init(void)
+{
+	DHT11::Init();
+}
+
+void DHT22_Init(void)
+{
+	DHT22::Init();
+}
+
+bool DHT_ClaimFlash(void)
+{
+	osKernelLock();
+	bool Claimed = (s_ActiveRounds == 0);
+	s_FlashClaimed = Claimed;
+	osKernelUnlock();
+
+	return Claimed;
+}
+
+void DHT_ReleaseFlash(void)
+{
+	osKernelLock();
+	s_FlashClaimed = false;
+	osKernelUnlock();
+}
+
+void DHT11_InterruptHandler(uint16_t GPIO_Pin)
+{
+	uint32_t Time = TIMER_CURRENT;
+	DHT11::HandleLineInterrupt(__builtin_ctz(GPIO_Pin), Time);
+}
+
+void DHT22_InterruptHandler(uint16_t GPIO_Pin)
+{
+	uint32_t Time = TIMER_CURRENT;
+	DHT22::HandleLineInterrupt(__builtin_ctz(GPIO_Pin), Time);
+}
+
+}
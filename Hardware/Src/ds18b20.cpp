@@ -0,0 +1,133 @@
+/*
+ * ds18b20.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "ds18b20.h"
+
+#include "logger.h"
+
+#include "cmsis_os2.h"
+
+static constexpr LoggerModule s_OneWireModule(LogModuleId::OneWire);
+
+// Per-read logs are limited to a few per burst of reads, then one per period
+static constexpr uint16_t s_ReadLogBurst = 8;
+static constexpr uint32_t s_ReadLogPeriodMs = 10000;
+
+DS18B20::DS18B20(OneWire *pBus) :
+		m_pBus(pBus),
+		m_Roms{0},
+		m_NumProbes(0)
+{
+}
+
+size_t DS18B20::Discover(void)
+{
+	m_pBus->Lock();
+	size_t NumRoms = m_pBus->Search(m_Roms, s_MaxProbes);
+	m_pBus->Unlock();
+
+	m_NumProbes = 0;
+
+	// Other 1-Wire devices may share the bus, probes are packed to the front
+	for (size_t Idx = 0; Idx < NumRoms; Idx++)
+	{
+		uint64_t Rom = m_Roms[Idx];
+		bool Probe = ((Rom & 0xFF) == s_FamilyCode);
+
+		if (Probe)
+		{
+			m_Roms[m_NumProbes++] = Rom;
+		}
+
+		LOG_INFO(&s_OneWireModule, "ROM %08lx%08lx%s", (uint32_t)(Rom >> 32), (uint32_t)Rom, Probe ? " DS18B20" : "");
+	}
+
+	LOG_INFO(&s_OneWireModule, "%d probes", m_NumProbes);
+
+	return m_NumProbes;
+}
+
+size_t DS18B20::GetNumProbes(void) const
+{
+	return m_NumProbes;
+}
+
+size_t DS18B20::ReadAll(int16_t *pTemperatures, bool *pValid)
+{
+	static constexpr uint8_t s_Convert[] = { OneWire::s_SkipRom, s_ConvertT };
+	size_t NumValid = 0;
+
+	for (size_t Idx = 0; Idx < m_NumProbes; Idx++)
+	{
+		pValid[Idx] = false;
+	}
+
+	if (m_NumProbes == 0)
+	{
+		return 0;
+	}
+
+	// Skip ROM addresses every probe, they all convert together
+	m_pBus->Lock();
+	bool Started = m_pBus->Reset() && m_pBus->Transfer(s_Convert, sizeof(s_Convert), nullptr, 0);
+	m_pBus->Unlock();
+
+	if (!Started)
+	{
+		LOG_LIMITED_AT(&s_OneWireModule, LogLevel::Warn, s_ReadLogBurst, s_ReadLogPeriodMs, "No presence pulse");
+		return 0;
+	}
+
+	// The bus is free for others during the conversion
+	osDelay(pdMS_TO_TICKS(s_ConversionTimeMs));
+
+	for (size_t Idx = 0; Idx < m_NumProbes; Idx++)
+	{
+		pValid[Idx] = ReadProbe(Idx, &pTemperatures[Idx]);
+		NumValid += pValid[Idx] ? 1 : 0;
+	}
+
+	return NumValid;
+}
+
+bool DS18B20::ReadProbe(size_t Probe, int16_t *pTemperature)
+{
+	uint8_t Command[2 + sizeof(uint64_t)];
+	uint8_t Scratchpad[s_ScratchpadLength];
+
+	// Match ROM, the ROM least significant byte first, then the function command
+	Command[0] = OneWire::s_MatchRom;
+
+	for (size_t Idx = 0; Idx < sizeof(uint64_t); Idx++)
+	{
+		Command[1 + Idx] = (uint8_t)(m_Roms[Probe] >> (8 * Idx));
+	}
+
+	Command[1 + sizeof(uint64_t)] = s_ReadScratchpad;
+
+	m_pBus->Lock();
+	bool Read = m_pBus->Reset() && m_pBus->Transfer(Command, sizeof(Command), Scratchpad, sizeof(Scratchpad));
+	m_pBus->Unlock();
+
+	// A stuck bus passes the CRC as all zeros, the configuration byte's fixed bits
+	// tell it from a probe
+	if (!Read || (OneWire::Crc8(Scratchpad, sizeof(Scratchpad)) != 0) ||
+		((Scratchpad[s_ConfigurationByte] & s_ConfigurationMask) != s_ConfigurationFixed))
+	{
+		LOG_LIMITED_AT(&s_OneWireModule, LogLevel::Warn, s_ReadLogBurst, s_ReadLogPeriodMs, "%d Bad read", Probe);
+		return false;
+	}
+
+	// Sixteenths of a degree, converted to tenths
+	int16_t Raw = (int16_t)((Scratchpad[1] << 8) | Scratchpad[0]);
+	*pTemperature = (int16_t)((Raw * 10) / 16);
+
+	LOG_LIMITED_AT(&s_OneWireModule, LogLevel::Debug, s_ReadLogBurst, s_ReadLogPeriodMs, "%d %d tenths C", Probe,
+			*pTemperature);
+
+	return true;
+}
@@ -0,0 +1,189 @@
+/*
+ * edge_capture.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "edge_capture.h"
+
+// Captures with a DMA channel to route interrupts to, one per capable timer
+static constexpr size_t s_MaxCaptures = 3;
+static EdgeCapture *s_pCaptures[s_MaxCaptures];
+static DMA_Channel_TypeDef *s_pCaptureDmas[s_MaxCaptures];
+static size_t s_NumCaptures = 0;
+
+// Must be able to use the FreeRTOS FromISR API
+static constexpr uint32_t s_DmaInterruptPriority = 5;
+
+/**
+ * @brief	Gets the position of a DMA1 channel's flags in ISR and IFCR
+ */
+static uint32_t DmaFlagShift(DMA_Channel_TypeDef *pDma)
+{
+	uint32_t Stride = (uintptr_t)DMA1_Channel2 - (uintptr_t)DMA1_Channel1;
+	return 4 * (((uintptr_t)pDma - (uintptr_t)DMA1_Channel1) / Stride);
+}
+
+/**
+ * @brief	Gets the clock the APB1 timers count, twice PCLK1 unless APB1 is undivided
+ */
+static uint32_t TimerClockHz(void)
+{
+	uint32_t Pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) ? Pclk1 : (2 * Pclk1);
+}
+
+EdgeCapture::EdgeCapture(TIM_TypeDef *pTimer, DMA_Channel_TypeDef *pDma, IRQn_Type DmaInterrupt) :
+		m_pTimer(pTimer),
+		m_pDma(pDma),
+		m_DmaInterrupt(DmaInterrupt),
+		m_DmaFlagShift(DmaFlagShift(pDma)),
+		m_Edges{0},
+		m_NumEdges(0),
+		m_Running(false),
+		m_Done(nullptr),
+		m_pContext(nullptr)
+{
+}
+
+bool EdgeCapture::Init(void)
+{
+	if (s_NumCaptures >= s_MaxCaptures)
+	{
+		return false;
+	}
+
+	s_pCaptures[s_NumCaptures] = this;
+	s_pCaptureDmas[s_NumCaptures] = m_pDma;
+	s_NumCaptures++;
+
+	switch ((uintptr_t)m_pTimer)
+	{
+	case TIM2_BASE:
+		__HAL_RCC_TIM2_CLK_ENABLE();
+		break;
+	case TIM3_BASE:
+		__HAL_RCC_TIM3_CLK_ENABLE();
+		break;
+	case TIM4_BASE:
+		__HAL_RCC_TIM4_CLK_ENABLE();
+		break;
+	}
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	m_pTimer->CR1 = 0;
+	m_pTimer->PSC = (TimerClockHz() / s_TickRateHz) - 1;
+	m_pTimer->ARR = s_TickMask;
+
+	// IC1 on TRC with the TI1 edge detector as trigger captures both edges. The
+	// filter needs eight samples at the timer clock to accept a level, ~110ns.
+	m_pTimer->CCER = 0;
+	m_pTimer->CCMR1 = TIM_CCMR1_CC1S | TIM_CCMR1_IC1F_0 | TIM_CCMR1_IC1F_1;
+	m_pTimer->SMCR = TIM_SMCR_TS_2;
+	m_pTimer->CCER = TIM_CCER_CC1E;
+
+	// Load the prescaler before counting
+	m_pTimer->EGR = TIM_EGR_UG;
+	m_pTimer->CR1 = TIM_CR1_CEN;
+
+	HAL_NVIC_SetPriority(m_DmaInterrupt, s_DmaInterruptPriority, 0);
+	HAL_NVIC_EnableIRQ(m_DmaInterrupt);
+
+	return true;
+}
+
+bool EdgeCapture::Start(size_t NumEdges, Callback Done, void *pContext)
+{
+	if (m_Running || (NumEdges > s_MaxEdges))
+	{
+		return false;
+	}
+
+	m_NumEdges = NumEdges;
+	m_Done = Done;
+	m_pContext = pContext;
+
+	m_pDma->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_DmaFlagShift;
+
+	// Edges from before the start must not be the first capture
+	(void) m_pTimer->CCR1;
+	m_pTimer->SR = ~(uint32_t)(TIM_SR_CC1IF | TIM_SR_CC1OF);
+
+	m_pDma->CPAR = (uint32_t)(uintptr_t)&m_pTimer->CCR1;
+	m_pDma->CMAR = (uint32_t)(uintptr_t)m_Edges;
+	m_pDma->CNDTR = NumEdges;
+	m_pDma->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 | DMA_CCR_PL_1 | DMA_CCR_TCIE |
+			DMA_CCR_TEIE | DMA_CCR_EN;
+
+	m_Running = true;
+	m_pTimer->DIER |= TIM_DIER_CC1DE;
+
+	return true;
+}
+
+size_t EdgeCapture::Stop(void)
+{
+	// Keep the completion interrupt from racing the stop
+	HAL_NVIC_DisableIRQ(m_DmaInterrupt);
+
+	m_pTimer->DIER &= ~TIM_DIER_CC1DE;
+	m_pDma->CCR &= ~DMA_CCR_EN;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_DmaFlagShift;
+
+	size_t Captured = m_Running ? (m_NumEdges - m_pDma->CNDTR) : m_NumEdges;
+	m_Running = false;
+
+	HAL_NVIC_EnableIRQ(m_DmaInterrupt);
+
+	return Captured;
+}
+
+const uint16_t *EdgeCapture::GetEdges(void) const
+{
+	return m_Edges;
+}
+
+IRQn_Type EdgeCapture::GetDmaInterrupt(void) const
+{
+	return m_DmaInterrupt;
+}
+
+void EdgeCapture::HandleDmaInterrupt(void)
+{
+	uint32_t Flags = DMA1->ISR >> m_DmaFlagShift;
+
+	if (!(Flags & (DMA_ISR_TCIF1 | DMA_ISR_TEIF1)))
+	{
+		return;
+	}
+
+	m_pTimer->DIER &= ~TIM_DIER_CC1DE;
+	m_pDma->CCR &= ~DMA_CCR_EN;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_DmaFlagShift;
+	m_Running = false;
+
+	// A transfer error leaves the reader to time out
+	if ((Flags & DMA_ISR_TCIF1) && (m_Done != nullptr))
+	{
+		m_Done(m_pContext);
+	}
+}
+
+extern "C" {
+
+void EdgeCapture_DmaInterruptHandler(DMA_Channel_TypeDef *pDma)
+{
+	for (size_t Idx = 0; Idx < s_NumCaptures; Idx++)
+	{
+		if (s_pCaptureDmas[Idx] == pDma)
+		{
+			s_pCaptures[Idx]->HandleDmaInterrupt();
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,481 @@
+/*
+ * i2c_master.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "i2c_master.h"
+
+#include "logger.h"
+#include "timebase.h"
+
+static constexpr LoggerModule s_I2cModule(LogModuleId::I2c);
+
+// Buses to route interrupts to, one per peripheral
+static constexpr size_t s_MaxBuses = 2;
+static I2cMaster *s_pBuses[s_MaxBuses];
+static I2C_TypeDef *s_pBusPeripherals[s_MaxBuses];
+static size_t s_NumBuses = 0;
+
+// Must be able to use the FreeRTOS FromISR API
+static constexpr uint32_t s_InterruptPriority = 5;
+
+// Error flags, cleared by writing zero
+static constexpr uint32_t s_ErrorFlags = I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR |
+		I2C_SR1_PECERR | I2C_SR1_TIMEOUT | I2C_SR1_SMBALERT;
+
+// Longest wait for the last stop to go out before the bus counts as stuck
+static constexpr uint32_t s_IdleTimeoutMs = 3;
+
+// Half an SCL period when clocking the bus by hand
+static constexpr uint32_t s_RecoveryHalfBitUs = 5;
+
+/**
+ * @brief	Busy waits, only while recovering the bus
+ */
+static void DelayUs(uint32_t Us)
+{
+	uint64_t Start = Timebase_GetCycles();
+
+	while (Timebase_CyclesToUs(Timebase_GetCycles() - Start) < Us)
+	{
+	}
+}
+
+I2cMaster::I2cMaster(I2C_TypeDef *pI2c, IRQn_Type EventInterrupt, IRQn_Type ErrorInterrupt, GPIO_TypeDef *pPort,
+		uint32_t SclPin, uint32_t SdaPin) :
+		m_pI2c(pI2c),
+		m_EventInterrupt(EventInterrupt),
+		m_ErrorInterrupt(ErrorInterrupt),
+		m_pPort(pPort),
+		m_SclPin(SclPin),
+		m_SdaPin(SdaPin),
+		m_pCurrent(nullptr),
+		m_Index(0),
+		m_Reading(false),
+		m_RestartPending(false),
+		m_TaskControlBlock(),
+		m_TaskStack{0},
+		m_ServiceTask(nullptr),
+		m_QueueControlBlock(),
+		m_QueueStorage{0},
+		m_Queue(nullptr)
+{
+}
+
+bool I2cMaster::Init(void)
+{
+	if (s_NumBuses >= s_MaxBuses)
+	{
+		return false;
+	}
+
+	s_pBuses[s_NumBuses] = this;
+	s_pBusPeripherals[s_NumBuses] = m_pI2c;
+	s_NumBuses++;
+
+	if (m_pI2c == I2C1)
+	{
+		__HAL_RCC_I2C1_CLK_ENABLE();
+
+		if (m_SclPin == 8)
+		{
+			__HAL_AFIO_REMAP_I2C1_ENABLE();
+		}
+	}
+	else
+	{
+		__HAL_RCC_I2C2_CLK_ENABLE();
+	}
+
+	// Clears a bus left busy by a reset mid-transaction too
+	Recover();
+
+	const osThreadAttr_t TaskAttributes = {
+		.name = "I2C_Task",
+		.cb_mem = &m_TaskControlBlock,
+		.cb_size = sizeof(m_TaskControlBlock),
+		.stack_mem = m_TaskStack,
+		.stack_size = sizeof(m_TaskStack),
+		.priority = (osPriority_t) osPriorityAboveNormal,
+	};
+
+	m_Queue = xQueueCreateStatic(s_QueueLength, sizeof(I2cTransaction *), m_QueueStorage, &m_QueueControlBlock);
+	m_ServiceTask = osThreadNew(ServiceTask, this, &TaskAttributes);
+
+	HAL_NVIC_SetPriority(m_EventInterrupt, s_InterruptPriority, 0);
+	HAL_NVIC_SetPriority(m_ErrorInterrupt, s_InterruptPriority, 0);
+	HAL_NVIC_EnableIRQ(m_EventInterrupt);
+	HAL_NVIC_EnableIRQ(m_ErrorInterrupt);
+
+	return true;
+}
+
+void I2cMaster::Configure(void)
+{
+	uint32_t Pclk1 = HAL_RCC_GetPCLK1Freq();
+	uint32_t Pclk1Mhz = Pclk1 / 1000000;
+
+	// Standard mode, SCL high and low for CCR clocks each, rise time at most 1us
+	m_pI2c->CR1 = 0;
+	m_pI2c->CR2 = Pclk1Mhz;
+	m_pI2c->CCR = Pclk1 / (2 * s_ClockHz);
+	m_pI2c->TRISE = Pclk1Mhz + 1;
+	m_pI2c->CR1 = I2C_CR1_PE;
+}
+
+void I2cMaster::ConfigurePins(bool Peripheral)
+{
+	// Alternate function or general purpose output, open drain either way
+	uint32_t Mode = Peripheral ? 0x0F : 0x07;
+	uint32_t Pins[] = { m_SclPin, m_SdaPin };
+
+	for (uint32_t Pin : Pins)
+	{
+		volatile uint32_t *pConfig = (Pin < 8) ? &m_pPort->CRL : &m_pPort->CRH;
+		uint32_t Pos = 4 * (Pin % 8);
+		*pConfig = (*pConfig & ~(0x0FUL << Pos)) | (Mode << Pos);
+	}
+}
+
+void I2cMaster::Recover(void)
+{
+	uint32_t Scl = 1 << m_SclPin;
+	uint32_t Sda = 1 << m_SdaPin;
+
+	m_pI2c->CR1 = 0;
+	m_pPort->BSRR = Scl | Sda;
+	ConfigurePins(false);
+
+	// A slave interrupted mid-byte holds SDA low until it has clocked the byte out
+	for (uint32_t Clock = 0; (Clock < 9) && !(m_pPort->IDR & Sda); Clock++)
+	{
+		m_pPort->BRR = Scl;
+		DelayUs(s_RecoveryHalfBitUs);
+		m_pPort->BSRR = Scl;
+		DelayUs(s_RecoveryHalfBitUs);
+	}
+
+	// Stop condition, SDA rising while SCL is high
+	m_pPort->BRR = Scl;
+	DelayUs(s_RecoveryHalfBitUs);
+	m_pPort->BRR = Sda;
+	DelayUs(s_RecoveryHalfBitUs);
+	m_pPort->BSRR = Scl;
+	DelayUs(s_RecoveryHalfBitUs);
+	m_pPort->BSRR = Sda;
+	DelayUs(s_RecoveryHalfBitUs);
+
+	// The reset also clears a BUSY flag latched by a glitch while the pins were ours
+	ConfigurePins(true);
+	m_pI2c->CR1 = I2C_CR1_SWRST;
+	m_pI2c->CR1 = 0;
+	Configure();
+}
+
+bool I2cMaster::Submit(I2cTransaction *pTransaction)
+{
+	// Claim the transaction, a queued one keeps its place
+	osKernelLock();
+	I2cResult Previous = pTransaction->Result;
+	bool Claimed = (Previous != I2cResult::Queued);
+
+	if (Claimed)
+	{
+		pTransaction->Result = I2cResult::Queued;
+	}
+
+	osKernelUnlock();
+
+	if (!Claimed)
+	{
+		return false;
+	}
+
+	if (xQueueSendToBack(m_Queue, &pTransaction, 0) != pdTRUE)
+	{
+		pTransaction->Result = Previous;
+		return false;
+	}
+
+	return true;
+}
+
+void I2cMaster::ServiceTask(void *pArgument)
+{
+	I2cMaster *pBus = (I2cMaster *)pArgument;
+	I2cTransaction *pTransaction = nullptr;
+
+	while (1)
+	{
+		xQueueReceive(pBus->m_Queue, &pTransaction, portMAX_DELAY);
+
+		// Taken before the result is published, the driver may submit it again from Done
+		void (*Done)(I2cTransaction *) = pTransaction->Done;
+		pTransaction->Result = pBus->Execute(pTransaction);
+
+		if (Done != nullptr)
+		{
+			Done(pTransaction);
+		}
+	}
+}
+
+bool I2cMaster::WaitIdle(void)
+{
+	uint32_t StartTick = osKernelGetTickCount();
+
+	while ((m_pI2c->CR1 & I2C_CR1_STOP) || (m_pI2c->SR2 & I2C_SR2_BUSY))
+	{
+		if ((osKernelGetTickCount() - StartTick) >= pdMS_TO_TICKS(s_IdleTimeoutMs))
+		{
+			return false;
+		}
+
+		osDelay(1);
+	}
+
+	return true;
+}
+
+I2cResult I2cMaster::Execute(I2cTransaction *pTransaction)
+{
+	if (!WaitIdle())
+	{
+		LOG_WARN(&s_I2cModule, "%02x Bus busy, recovering", pTransaction->Address);
+		Recover();
+	}
+
+	// Drop the wake up of a transaction that finished after timing out
+	ulTaskNotifyTake(pdTRUE, 0);
+
+	m_Index = 0;
+	m_Reading = (pTransaction->NumWrite == 0);
+	m_RestartPending = false;
+	m_pCurrent = pTransaction;
+
+	m_pI2c->CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+	m_pI2c->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN;
+
+	if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(s_TransactionTimeoutMs)) == 0)
+	{
+		// Keep the interrupts from finishing it under us
+		HAL_NVIC_DisableIRQ(m_EventInterrupt);
+		HAL_NVIC_DisableIRQ(m_ErrorInterrupt);
+		m_pCurrent = nullptr;
+		m_pI2c->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN);
+		HAL_NVIC_EnableIRQ(m_EventInterrupt);
+		HAL_NVIC_EnableIRQ(m_ErrorInterrupt);
+
+		LOG_WARN(&s_I2cModule, "%02x Timed out after %d bytes, SR1 %04lx SR2 %04lx", pTransaction->Address,
+				m_Index, m_pI2c->SR1, m_pI2c->SR2);
+		Recover();
+		return I2cResult::Timeout;
+	}
+
+	I2cResult Result = pTransaction->Result;
+
+	if (Result == I2cResult::BusError)
+	{
+		LOG_WARN(&s_I2cModule, "%02x Bus error, recovering", pTransaction->Address);
+		Recover();
+	}
+
+	return Result;
+}
+
+void I2cMaster::Finish(I2cResult Result)
+{
+	I2cTransaction *pTransaction = m_pCurrent;
+	BaseType_t Woken = pdFALSE;
+
+	m_pI2c->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN);
+	m_pI2c->CR1 &= ~I2C_CR1_POS;
+
+	m_pCurrent = nullptr;
+	pTransaction->Result = Result;
+
+	vTaskNotifyGiveFromISR((TaskHandle_t)m_ServiceTask, &Woken);
+	portYIELD_FROM_ISR(Woken);
+}
+
+void I2cMaster::HandleEventInterrupt(void)
+{
+	I2cTransaction *pTransaction = m_pCurrent;
+	uint32_t Status = m_pI2c->SR1;
+
+	if (pTransaction == nullptr)
+	{
+		m_pI2c->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN | I2C_CR2_ITERREN);
+		return;
+	}
+
+	// Start sent, reading SR1 then writing DR clears it
+	if (Status & I2C_SR1_SB)
+	{
+		m_pI2c->DR = (uint8_t)((pTransaction->Address << 1) | (m_Reading ? 1 : 0));
+
+		if (m_RestartPending)
+		{
+			m_RestartPending = false;
+			m_pI2c->CR2 |= I2C_CR2_ITBUFEN;
+		}
+
+		return;
+	}
+
+	// The last write's BTF stays set until the repeated start is on the bus, it must
+	// not be taken for a received byte
+	if (m_RestartPending)
+	{
+		return;
+	}
+
+	// Address acknowledged, reading SR2 clears it. Receptions of one or two bytes must
+	// set up the NACK first and can't be interrupted between the two.
+	if (Status & I2C_SR1_ADDR)
+	{
+		uint32_t Primask = __get_PRIMASK();
+		__disable_irq();
+
+		if (m_Reading && (pTransaction->NumRead == 1))
+		{
+			m_pI2c->CR1 &= ~I2C_CR1_ACK;
+			(void) m_pI2c->SR2;
+			m_pI2c->CR1 |= I2C_CR1_STOP;
+		}
+		else if (m_Reading && (pTransaction->NumRead == 2))
+		{
+			m_pI2c->CR1 = (m_pI2c->CR1 & ~I2C_CR1_ACK) | I2C_CR1_POS;
+			(void) m_pI2c->SR2;
+			m_pI2c->CR2 &= ~I2C_CR2_ITBUFEN;
+		}
+		else
+		{
+			(void) m_pI2c->SR2;
+
+			// Three bytes left already, the last two are closed on byte transfer finished
+			if (m_Reading && (pTransaction->NumRead == 3))
+			{
+				m_pI2c->CR2 &= ~I2C_CR2_ITBUFEN;
+			}
+		}
+
+		__set_PRIMASK(Primask);
+		return;
+	}
+
+	if (m_Reading)
+	{
+		size_t Remaining = pTransaction->NumRead - m_Index;
+
+		if ((Status & I2C_SR1_BTF) && (Remaining == 3))
+		{
+			// Byte N-2 in DR and N-1 in the shift register, NACK byte N as it arrives
+			m_pI2c->CR1 &= ~I2C_CR1_ACK;
+			pTransaction->pRead[m_Index++] = (uint8_t)m_pI2c->DR;
+			m_pI2c->CR1 |= I2C_CR1_STOP;
+			pTransaction->pRead[m_Index++] = (uint8_t)m_pI2c->DR;
+			m_pI2c->CR2 |= I2C_CR2_ITBUFEN;
+		}
+		else if ((Status & I2C_SR1_BTF) && (Remaining == 2))
+		{
+			m_pI2c->CR1 |= I2C_CR1_STOP;
+			pTransaction->pRead[m_Index++] = (uint8_t)m_pI2c->DR;
+			pTransaction->pRead[m_Index++] = (uint8_t)m_pI2c->DR;
+			Finish(I2cResult::Ok);
+		}
+		else if ((Status & I2C_SR1_RXNE) && ((Remaining == 1) || (Remaining > 3)))
+		{
+			pTransaction->pRead[m_Index++] = (uint8_t)m_pI2c->DR;
+
+			if (Remaining == 1)
+			{
+				Finish(I2cResult::Ok);
+			}
+			else if (Remaining == 4)
+			{
+				m_pI2c->CR2 &= ~I2C_CR2_ITBUFEN;
+			}
+		}
+
+		return;
+	}
+
+	if ((Status & I2C_SR1_TXE) && (m_Index < pTransaction->NumWrite))
+	{
+		m_pI2c->DR = pTransaction->pWrite[m_Index++];
+
+		// The last byte is done on byte transfer finished, once it's acknowledged
+		if (m_Index == pTransaction->NumWrite)
+		{
+			m_pI2c->CR2 &= ~I2C_CR2_ITBUFEN;
+		}
+	}
+	else if (Status & I2C_SR1_BTF)
+	{
+		if (pTransaction->NumRead > 0)
+		{
+			m_Reading = true;
+			m_RestartPending = true;
+			m_Index = 0;
+			m_pI2c->CR1 |= I2C_CR1_START;
+		}
+		else
+		{
+			m_pI2c->CR1 |= I2C_CR1_STOP;
+			Finish(I2cResult::Ok);
+		}
+	}
+}
+
+void I2cMaster::HandleErrorInterrupt(void)
+{
+	uint32_t Status = m_pI2c->SR1;
+	m_pI2c->SR1 = (uint16_t)~(Status & s_ErrorFlags);
+
+	if (m_pCurrent == nullptr)
+	{
+		return;
+	}
+
+	// A NACK leaves the bus to us, release it. Anything else needs a recovery.
+	if ((Status & s_ErrorFlags) == I2C_SR1_AF)
+	{
+		m_pI2c->CR1 |= I2C_CR1_STOP;
+		Finish(I2cResult::Nack);
+	}
+	else if (Status & s_ErrorFlags)
+	{
+		Finish(I2cResult::BusError);
+	}
+}
+
+extern "C" {
+
+void I2cMaster_EventInterruptHandler(I2C_TypeDef *pI2c)
+{
+	for (size_t Idx = 0; Idx < s_NumBuses; Idx++)
+	{
+		if (s_pBusPeripherals[Idx] == pI2c)
+		{
+			s_pBuses[Idx]->HandleEventInterrupt();
+			return;
+		}
+	}
+}
+
+void I2cMaster_ErrorInterruptHandler(I2C_TypeDef *pI2c)
+{
+	for (size_t Idx = 0; Idx < s_NumBuses; Idx++)
+	{
+		if (s_pBusPeripherals[Idx] == pI2c)
+		{
+			s_pBuses[Idx]->HandleErrorInterrupt();
+			return;
+		}
+	}
+}
+
+}
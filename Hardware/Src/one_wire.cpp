@@ -0,0 +1,355 @@
+/*
+ * one_wire.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "one_wire.h"
+
+#include <string.h>
+
+#include "logger.h"
+
+static constexpr LoggerModule s_OneWireModule(LogModuleId::OneWire);
+
+// Buses with an RX DMA channel to route interrupts to
+static constexpr size_t s_MaxBuses = 2;
+static OneWire *s_pBuses[s_MaxBuses];
+static DMA_Channel_TypeDef *s_pBusDmas[s_MaxBuses];
+static size_t s_NumBuses = 0;
+
+// Must be able to use the FreeRTOS FromISR API
+static constexpr uint32_t s_DmaInterruptPriority = 5;
+
+/**
+ * @brief	Gets the position of a DMA1 channel's flags in ISR and IFCR
+ */
+static uint32_t DmaFlagShift(DMA_Channel_TypeDef *pDma)
+{
+	uint32_t Stride = (uintptr_t)DMA1_Channel2 - (uintptr_t)DMA1_Channel1;
+	return 4 * (((uintptr_t)pDma - (uintptr_t)DMA1_Channel1) / Stride);
+}
+
+OneWire::OneWire(USART_TypeDef *pUsart, DMA_Channel_TypeDef *pTxDma, DMA_Channel_TypeDef *pRxDma,
+		IRQn_Type RxDmaInterrupt, GPIO_TypeDef *pPort, uint32_t Pin) :
+		m_pUsart(pUsart),
+		m_pTxDma(pTxDma),
+		m_pRxDma(pRxDma),
+		m_RxDmaInterrupt(RxDmaInterrupt),
+		m_pPort(pPort),
+		m_Pin(Pin),
+		m_RxDmaFlagShift(DmaFlagShift(pRxDma)),
+		m_Slots{0},
+		m_Baud(0),
+		m_LockControlBlock(),
+		m_Lock(xSemaphoreCreateMutexStatic(&m_LockControlBlock)),
+		m_DoneControlBlock(),
+		m_Done(xSemaphoreCreateBinaryStatic(&m_DoneControlBlock))
+{
+}
+
+bool OneWire::Init(void)
+{
+	if (s_NumBuses >= s_MaxBuses)
+	{
+		return false;
+	}
+
+	s_pBuses[s_NumBuses] = this;
+	s_pBusDmas[s_NumBuses] = m_pRxDma;
+	s_NumBuses++;
+
+	// The HAL handle was de-initialised, which stopped the USART's clock
+	switch ((uintptr_t)m_pUsart)
+	{
+	case USART1_BASE:
+		__HAL_RCC_USART1_CLK_ENABLE();
+		break;
+	case USART2_BASE:
+		__HAL_RCC_USART2_CLK_ENABLE();
+		break;
+	case USART3_BASE:
+		__HAL_RCC_USART3_CLK_ENABLE();
+		break;
+	}
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	// The TX pin drives the bus, alternate function open drain
+	volatile uint32_t *pConfig = (m_Pin < 8) ? &m_pPort->CRL : &m_pPort->CRH;
+	uint32_t Pos = 4 * (m_Pin % 8);
+	*pConfig = (*pConfig & ~(0x0FUL << Pos)) | (0x0FUL << Pos);
+
+	// Half duplex receives the bus on the TX pin, every slot sent is read back. No
+	// USART interrupts, the HAL de-initialisation left its interrupt disabled.
+	m_pUsart->CR1 = 0;
+	m_pUsart->CR2 = 0;
+	m_pUsart->CR3 = USART_CR3_HDSEL | USART_CR3_DMAT | USART_CR3_DMAR;
+	SetBaud(s_SlotBaud);
+	m_pUsart->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+
+	m_pTxDma->CPAR = (uint32_t)(uintptr_t)&m_pUsart->DR;
+	m_pRxDma->CPAR = (uint32_t)(uintptr_t)&m_pUsart->DR;
+
+	HAL_NVIC_SetPriority(m_RxDmaInterrupt, s_DmaInterruptPriority, 0);
+	HAL_NVIC_EnableIRQ(m_RxDmaInterrupt);
+
+	return true;
+}
+
+void OneWire::Lock(void)
+{
+	xSemaphoreTake(m_Lock, portMAX_DELAY);
+}
+
+void OneWire::Unlock(void)
+{
+	xSemaphoreGive(m_Lock);
+}
+
+void OneWire::SetBaud(uint32_t Baud)
+{
+	uint32_t Clock = (m_pUsart == USART1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+
+	// Only written between transfers, the transmitter is idle
+	m_pUsart->BRR = (Clock + (Baud / 2)) / Baud;
+	m_Baud = Baud;
+}
+
+bool OneWire::Exchange(size_t NumSlots, uint32_t Baud)
+{
+	if (Baud != m_Baud)
+	{
+		SetBaud(Baud);
+	}
+
+	// Drop a completion and a byte left over from a transfer that timed out
+	xSemaphoreTake(m_Done, 0);
+	(void) m_pUsart->SR;
+	(void) m_pUsart->DR;
+
+	m_pRxDma->CCR = 0;
+	m_pTxDma->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_RxDmaFlagShift;
+
+	// Receive is armed first, sending starts the moment its channel is enabled. Each
+	// slot is read back after the next one has been loaded, so both share a buffer.
+	m_pRxDma->CMAR = (uint32_t)(uintptr_t)m_Slots;
+	m_pRxDma->CNDTR = NumSlots;
+	m_pRxDma->CCR = DMA_CCR_MINC | DMA_CCR_PL_1 | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_EN;
+
+	m_pTxDma->CMAR = (uint32_t)(uintptr_t)m_Slots;
+	m_pTxDma->CNDTR = NumSlots;
+	m_pTxDma->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_PL_1 | DMA_CCR_EN;
+
+	// Ten bits a slot, with a tick of margin either side
+	uint32_t TimeoutMs = ((NumSlots * 10 * 1000) / Baud) + 2;
+
+	if (xSemaphoreTake(m_Done, pdMS_TO_TICKS(TimeoutMs)) != pdTRUE)
+	{
+		// A transfer error leaves the transfer to time out too
+		HAL_NVIC_DisableIRQ(m_RxDmaInterrupt);
+		m_pTxDma->CCR = 0;
+		m_pRxDma->CCR = 0;
+		DMA1->IFCR = DMA_IFCR_CGIF1 << m_RxDmaFlagShift;
+		HAL_NVIC_EnableIRQ(m_RxDmaInterrupt);
+
+		LOG_WARN(&s_OneWireModule, "%d slots at %lu baud timed out, %d left", NumSlots, Baud,
+				m_pRxDma->CNDTR);
+		return false;
+	}
+
+	return true;
+}
+
+bool OneWire::Reset(void)
+{
+	m_Slots[0] = s_ResetSlot;
+
+	// A presence pulse pulls the line low during the high bits of the slot
+	return Exchange(1, s_ResetBaud) && (m_Slots[0] != s_ResetSlot);
+}
+
+bool OneWire::Transfer(const uint8_t *pWrite, size_t NumWrite, uint8_t *pRead, size_t NumRead)
+{
+	if ((NumWrite + NumRead) > s_MaxTransferBytes)
+	{
+		return false;
+	}
+
+	size_t NumSlots = 0;
+
+	for (size_t Idx = 0; Idx < NumWrite; Idx++)
+	{
+		for (uint32_t Bit = 0; Bit < 8; Bit++)
+		{
+			m_Slots[NumSlots++] = ((pWrite[Idx] >> Bit) & 1) ? s_OneSlot : s_ZeroSlot;
+		}
+	}
+
+	memset(&m_Slots[NumSlots], s_OneSlot, 8 * NumRead);
+
+	if (!Exchange(NumSlots + (8 * NumRead), s_SlotBaud))
+	{
+		return false;
+	}
+
+	for (size_t Idx = 0; Idx < NumRead; Idx++)
+	{
+		uint8_t Byte = 0;
+
+		// A device sending a zero holds the line low past the start bit
+		for (uint32_t Bit = 0; Bit < 8; Bit++)
+		{
+			Byte |= (uint8_t)((m_Slots[NumSlots++] == s_OneSlot) << Bit);
+		}
+
+		pRead[Idx] = Byte;
+	}
+
+	return true;
+}
+
+size_t OneWire::Search(uint64_t *pRoms, size_t MaxRoms)
+{
+	size_t NumRoms = 0;
+	uint64_t Rom = 0;
+
+	// Bit positions from 1 where the last pass took the zero branch of a discrepancy
+	uint32_t LastDiscrepancy = 0;
+
+	while (NumRoms < MaxRoms)
+	{
+		if (!Reset() || !Transfer(&s_SearchRom, 1, nullptr, 0))
+		{
+			break;
+		}
+
+		uint32_t LastZero = 0;
+		size_t NumSlots = 0;
+		bool Failed = false;
+
+		// Every transfer sends the last bit's direction then reads the next bit and its
+		// complement, one transfer per bit
+		for (uint32_t Position = 1; Position <= 64; Position++)
+		{
+			m_Slots[NumSlots++] = s_OneSlot;
+			m_Slots[NumSlots++] = s_OneSlot;
+
+			if (!Exchange(NumSlots, s_SlotBaud))
+			{
+				Failed = true;
+				break;
+			}
+
+			bool IdBit = (m_Slots[NumSlots - 2] == s_OneSlot);
+			bool ComplementBit = (m_Slots[NumSlots - 1] == s_OneSlot);
+			bool Direction = IdBit;
+
+			// No device left on the branch
+			if (IdBit && ComplementBit)
+			{
+				Failed = true;
+				break;
+			}
+
+			// Devices differ here, repeat the last pass up to its last zero branch then
+			// take the one branch there and zero branches after it
+			if (IdBit == ComplementBit)
+			{
+				Direction = (Position < LastDiscrepancy) ? ((Rom >> (Position - 1)) & 1) :
+						(Position == LastDiscrepancy);
+
+				if (!Direction)
+				{
+					LastZero = Position;
+				}
+			}
+
+			Rom = (Rom & ~(1ULL << (Position - 1))) | ((uint64_t)Direction << (Position - 1));
+
+			m_Slots[0] = Direction ? s_OneSlot : s_ZeroSlot;
+			NumSlots = 1;
+		}
+
+		if (Failed || !Exchange(1, s_SlotBaud))
+		{
+			break;
+		}
+
+		uint8_t RomBytes[8];
+		memcpy(RomBytes, &Rom, sizeof(RomBytes));
+
+		if (Crc8(RomBytes, sizeof(RomBytes)) != 0)
+		{
+			LOG_WARN(&s_OneWireModule, "Bad ROM CRC, search stopped");
+			break;
+		}
+
+		pRoms[NumRoms++] = Rom;
+		LastDiscrepancy = LastZero;
+
+		if (LastDiscrepancy == 0)
+		{
+			break;
+		}
+	}
+
+	return NumRoms;
+}
+
+uint8_t OneWire::Crc8(const uint8_t *pData, size_t Length)
+{
+	uint8_t Crc = 0;
+
+	// Polynomial x^8 + x^5 + x^4 + 1, least significant bit first
+	for (size_t Idx = 0; Idx < Length; Idx++)
+	{
+		Crc ^= pData[Idx];
+
+		for (uint32_t Bit = 0; Bit < 8; Bit++)
+		{
+			Crc = (Crc & 1) ? ((Crc >> 1) ^ 0x8C) : (Crc >> 1);
+		}
+	}
+
+	return Crc;
+}
+
+void OneWire::HandleDmaInterrupt(void)
+{
+	uint32_t Flags = DMA1->ISR >> m_RxDmaFlagShift;
+
+	if (!(Flags & (DMA_ISR_TCIF1 | DMA_ISR_TEIF1)))
+	{
+		return;
+	}
+
+	m_pTxDma->CCR = 0;
+	m_pRxDma->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF1 << m_RxDmaFlagShift;
+
+	if (Flags & DMA_ISR_TCIF1)
+	{
+		BaseType_t Woken = pdFALSE;
+		xSemaphoreGiveFromISR(m_Done, &Woken);
+		portYIELD_FROM_ISR(Woken);
+	}
+}
+
+extern "C" {
+
+void OneWire_DmaInterruptHandler(DMA_Channel_TypeDef *pDma)
+{
+	for (size_t Idx = 0; Idx < s_NumBuses; Idx++)
+	{
+		if (s_pBusDmas[Idx] == pDma)
+		{
+			s_pBuses[Idx]->HandleDmaInterrupt();
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,216 @@
+/*
+ * sht3x.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "sht3x.h"
+
+#include "logger.h"
+
+static constexpr LoggerModule s_I2cModule(LogModuleId::I2c);
+
+// Per-fetch logs are limited to a few per burst of fetches, then one per period
+static constexpr uint16_t s_FetchLogBurst = 8;
+static constexpr uint32_t s_FetchLogPeriodMs = 10000;
+
+SHT3x::SHT3x(I2cMaster *pBus, uint8_t Address) :
+		m_pBus(pBus),
+		m_StartTransaction(),
+		m_FetchTransaction(),
+		m_BreakTransaction(),
+		m_Measurement{0},
+		m_Running(false),
+		m_NeedsBreak(false),
+		m_Nacks(0),
+		m_Temperature(0),
+		m_Humidity(0),
+		m_Tick(0),
+		m_Valid(false),
+		m_TimerControlBlock(),
+		m_FetchTimer(nullptr)
+{
+	m_StartTransaction.Address = Address;
+	m_StartTransaction.pWrite = s_StartPeriodic;
+	m_StartTransaction.NumWrite = sizeof(s_StartPeriodic);
+	m_StartTransaction.pRead = nullptr;
+	m_StartTransaction.NumRead = 0;
+	m_StartTransaction.Done = StartDone;
+	m_StartTransaction.pContext = this;
+	m_StartTransaction.Result = I2cResult::Ok;
+
+	m_FetchTransaction.Address = Address;
+	m_FetchTransaction.pWrite = s_FetchData;
+	m_FetchTransaction.NumWrite = sizeof(s_FetchData);
+	m_FetchTransaction.pRead = m_Measurement;
+	m_FetchTransaction.NumRead = sizeof(m_Measurement);
+	m_FetchTransaction.Done = FetchDone;
+	m_FetchTransaction.pContext = this;
+	m_FetchTransaction.Result = I2cResult::Ok;
+
+	m_BreakTransaction.Address = Address;
+	m_BreakTransaction.pWrite = s_Break;
+	m_BreakTransaction.NumWrite = sizeof(s_Break);
+	m_BreakTransaction.pRead = nullptr;
+	m_BreakTransaction.NumRead = 0;
+	m_BreakTransaction.Done = BreakDone;
+	m_BreakTransaction.pContext = this;
+	m_BreakTransaction.Result = I2cResult::Ok;
+}
+
+bool SHT3x::Start(void)
+{
+	const osTimerAttr_t TimerAttributes = {
+		.name = "SHT3x",
+		.cb_mem = &m_TimerControlBlock,
+		.cb_size = sizeof(m_TimerControlBlock),
+	};
+
+	m_pBus->Submit(&m_StartTransaction);
+
+	m_FetchTimer = osTimerNew(FetchTimer, osTimerPeriodic, this, &TimerAttributes);
+
+	return (m_FetchTimer != nullptr) && (osTimerStart(m_FetchTimer, pdMS_TO_TICKS(s_FetchPeriodMs)) == osOK);
+}
+
+bool SHT3x::GetLatest(int16_t *pTemperature, uint16_t *pHumidity, uint32_t *pTick) const
+{
+	osKernelLock();
+	bool Valid = m_Valid;
+	*pTemperature = m_Temperature;
+	*pHumidity = m_Humidity;
+
+	if (pTick != nullptr)
+	{
+		*pTick = m_Tick;
+	}
+
+	osKernelUnlock();
+
+	return Valid;
+}
+
+void SHT3x::FetchTimer(void *pArgument)
+{
+	SHT3x *pSensor = (SHT3x *)pArgument;
+
+	// Any may still be queued behind a slow bus, it's then skipped this period. The
+	// break and the start go out a period apart, the break takes up to 1ms.
+	if (pSensor->m_Running)
+	{
+		pSensor->m_pBus->Submit(&pSensor->m_FetchTransaction);
+	}
+	else if (pSensor->m_NeedsBreak)
+	{
+		pSensor->m_pBus->Submit(&pSensor->m_BreakTransaction);
+	}
+	else
+	{
+		pSensor->m_pBus->Submit(&pSensor->m_StartTransaction);
+	}
+}
+
+void SHT3x::StartDone(I2cTransaction *pTransaction)
+{
+	SHT3x *pSensor = (SHT3x *)pTransaction->pContext;
+
+	pSensor->m_Running = (pTransaction->Result == I2cResult::Ok);
+	pSensor->m_Nacks = 0;
+
+	// Already in periodic mode, if the sensor is there at all
+	if (!pSensor->m_Running)
+	{
+		pSensor->m_NeedsBreak = true;
+		LOG_LIMITED_AT(&s_I2cModule, LogLevel::Warn, s_FetchLogBurst, s_FetchLogPeriodMs, "%02x SHT3x didn't start",
+				pTransaction->Address);
+	}
+}
+
+void SHT3x::BreakDone(I2cTransaction *pTransaction)
+{
+	SHT3x *pSensor = (SHT3x *)pTransaction->pContext;
+
+	if (pTransaction->Result == I2cResult::Ok)
+	{
+		pSensor->m_NeedsBreak = false;
+	}
+}
+
+void SHT3x::FetchDone(I2cTransaction *pTransaction)
+{
+	SHT3x *pSensor = (SHT3x *)pTransaction->pContext;
+	const uint8_t *pData = pTransaction->pRead;
+
+	// NACKed when no new measurement is ready yet, but not for several periods running
+	if (pTransaction->Result == I2cResult::Nack)
+	{
+		if (++pSensor->m_Nacks < s_MaxNacks)
+		{
+			return;
+		}
+
+		// Out of periodic mode, the last measurement is going stale. Break and start again.
+		osKernelLock();
+		pSensor->m_Valid = false;
+		osKernelUnlock();
+
+		pSensor->m_Nacks = 0;
+		pSensor->m_Running = false;
+		pSensor->m_NeedsBreak = true;
+		LOG_LIMITED_AT(&s_I2cModule, LogLevel::Warn, s_FetchLogBurst, s_FetchLogPeriodMs,
+				"%02x SHT3x stopped measuring, restarting", pTransaction->Address);
+		return;
+	}
+
+	pSensor->m_Nacks = 0;
+
+	// The bus was recovered, the sensor may or may not have been reset with it
+	if (pTransaction->Result != I2cResult::Ok)
+	{
+		pSensor->m_Running = false;
+		pSensor->m_NeedsBreak = true;
+		return;
+	}
+
+	if ((Crc8(&pData[0], 3) != 0) || (Crc8(&pData[3], 3) != 0))
+	{
+		LOG_LIMITED_AT(&s_I2cModule, LogLevel::Warn, s_FetchLogBurst, s_FetchLogPeriodMs, "%02x SHT3x bad CRC",
+				pTransaction->Address);
+		return;
+	}
+
+	// Full scale is -45 to 130 degrees C and 0 to 100 %RH
+	uint32_t RawTemperature = (pData[0] << 8) | pData[1];
+	uint32_t RawHumidity = (pData[3] << 8) | pData[4];
+	int16_t Temperature = (int16_t)(-450 + (int32_t)((1750 * RawTemperature) / 65535));
+	uint16_t Humidity = (uint16_t)((1000 * RawHumidity) / 65535);
+
+	osKernelLock();
+	pSensor->m_Temperature = Temperature;
+	pSensor->m_Humidity = Humidity;
+	pSensor->m_Tick = osKernelGetTickCount();
+	pSensor->m_Valid = true;
+	osKernelUnlock();
+
+	LOG_LIMITED_AT(&s_I2cModule, LogLevel::Debug, s_FetchLogBurst, s_FetchLogPeriodMs, "%02x %d tenths C %d tenths %%RH",
+			pTransaction->Address, Temperature, Humidity);
+}
+
+uint8_t SHT3x::Crc8(const uint8_t *pData, size_t Length)
+{
+	// Polynomial 0x31, initial value 0xFF, most significant bit first
+	uint8_t Crc = 0xFF;
+
+	for (size_t Idx = 0; Idx < Length; Idx++)
+	{
+		Crc ^= pData[Idx];
+
+		for (uint32_t Bit = 0; Bit < 8; Bit++)
+		{
+			Crc = (Crc & 0x80) ? (uint8_t)((Crc << 1) ^ 0x31) : (uint8_t)(Crc << 1);
+		}
+	}
+
+	return Crc;
+}
@@ -0,0 +1,40 @@
+/*
+ * crc.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef LIB_INC_CRC_H_
+#define LIB_INC_CRC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Restarts the CRC unit at its initial value
+ * @note	The unit is shared and not reentrant, a calculation must not be preempted
+ * 			by another one. Enables the unit's clock on first use.
+ */
+void Crc_Reset(void);
+
+/**
+ * @brief	Feeds words into the running CRC
+ * @retval	CRC-32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection) so far
+ */
+uint32_t Crc_Accumulate(const uint32_t *pWords, size_t NumWords);
+
+/**
+ * @brief	Calculates the CRC of a block of words from scratch, see Crc_Accumulate
+ */
+uint32_t Crc_Calculate(const uint32_t *pWords, size_t NumWords);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIB_INC_CRC_H_ */
@@ -0,0 +1,40 @@
+/*
+ * format.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef LIB_INC_FORMAT_H_
+#define LIB_INC_FORMAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Integer-only vsnprintf replacement
+ * @note	Supports %d %i %u %x %X %s %c %p and %%, the '-' and '0' flags, widths and
+ * 			precisions (fixed or *), and the hh, h, l, ll and z length modifiers. No heap,
+ * 			no floating point, reentrant and a bounded stack. Unsupported conversions are
+ * 			copied to the output as-is.
+ * @param	pOut	Output buffer, may be NULL when Size is 0 to only measure
+ * @param	Size	Output buffer size, the output is always NUL terminated if non-zero
+ * @retval	Length the full output would have, excluding the terminator
+ */
+size_t Format_VPrint(char *pOut, size_t Size, const char *Format, va_list Args);
+
+/**
+ * @brief	Integer-only snprintf replacement, see Format_VPrint
+ */
+size_t Format_Print(char *pOut, size_t Size, const char *Format, ...) __attribute__((format(printf, 3, 4)));
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIB_INC_FORMAT_H_ */
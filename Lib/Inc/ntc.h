@@ -0,0 +1,40 @@
+/*
+ * ntc.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef LIB_INC_NTC_H_
+#define LIB_INC_NTC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Full scale of the codes converted, 12-bit samples oversampled to 14 bits
+ */
+#define NTC_CODE_FULL_SCALE		16384
+
+/**
+ * @brief	Converts a thermistor divider reading to a temperature
+ * @note	For a 10k NTC from the input to ground under a 10k pull-up to VDDA, so the
+ * 			reading doesn't depend on the supply. Integer only, a lookup table of the
+ * 			Steinhart-Hart equation interpolated linearly. Within 0.2 degrees C of the
+ * 			equation up to 100 degrees C, and 0.33 degrees C above, where the curve
+ * 			bends most between entries.
+ * @param	Code			Divider reading, out of NTC_CODE_FULL_SCALE
+ * @param	pTemperature	Tenths of a degree C
+ * @retval	false	Outside -40 to 125 degrees C, an open or shorted probe
+ */
+bool Ntc_ToTenths(uint16_t Code, int16_t *pTemperature);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIB_INC_NTC_H_ */
@@ -0,0 +1,39 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#ifndef LIB_INC_TIMEBASE_H_
+#define LIB_INC_TIMEBASE_H_
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief	Gets the 64-bit cycle count since DWT CYCCNT was enabled
+ * @note	Wait-free, safe to call from any task or interrupt. Nothing may write
+ * 			DWT->CYCCNT once running, measure intervals as differences instead.
+ */
+uint64_t Timebase_GetCycles(void);
+
+/**
+ * @brief	Tracks CYCCNT wraps, must run at least every 2^31 cycles (~29 s at 72 MHz)
+ * @note	Called from the HAL tick, must only be called from one context
+ */
+void Timebase_Update(void);
+
+/**
+ * @brief	Converts a cycle count to microseconds
+ */
+uint64_t Timebase_CyclesToUs(uint64_t Cycles);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIB_INC_TIMEBASE_H_ */
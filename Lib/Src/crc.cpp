@@ -0,0 +1,38 @@
+/*
+ * crc.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "crc.h"
+
+#include "stm32f1xx_hal.h"
+
+extern "C" {
+
+void Crc_Reset(void)
+{
+	// Register level, the HAL CRC driver isn't part of the project. Fault handlers use
+	// this too, so it must not depend on anything having been initialised.
+	RCC->AHBENR |= RCC_AHBENR_CRCEN;
+	CRC->CR = CRC_CR_RESET;
+}
+
+uint32_t Crc_Accumulate(const uint32_t *pWords, size_t NumWords)
+{
+	for (size_t Idx = 0; Idx < NumWords; Idx++)
+	{
+		CRC->DR = pWords[Idx];
+	}
+
+	return CRC->DR;
+}
+
+uint32_t Crc_Calculate(const uint32_t *pWords, size_t NumWords)
+{
+	Crc_Reset();
+	return Crc_Accumulate(pWords, NumWords);
+}
+
+}
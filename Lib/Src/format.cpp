@@ -0,0 +1,328 @@
+/*
+ * format.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "format.h"
+
+/**
+ * @brief	Bounded output, keeps counting once the buffer is full
+ */
+struct FormatOutput
+{
+	char *pOut;
+	size_t Size;
+	size_t Length;
+
+	void Put(char Character)
+	{
+		if ((Length + 1) < Size)
+		{
+			pOut[Length] = Character;
+		}
+
+		Length++;
+	}
+
+	void Repeat(char Character, int Count)
+	{
+		while (Count-- > 0)
+		{
+			Put(Character);
+		}
+	}
+};
+
+// Conversion flags
+static constexpr uint8_t s_FlagLeft = 0x01;
+static constexpr uint8_t s_FlagZero = 0x02;
+
+// Enough for a 64-bit value in decimal
+static constexpr size_t s_MaxDigits = 20;
+
+/**
+ * @brief	Writes an integer conversion
+ * @param	Value		Magnitude to print
+ * @param	Negative	Prefix a minus sign
+ * @param	Base		10 or 16
+ * @param	Precision	Minimum number of digits, negative if none given
+ */
+static void PutInteger(FormatOutput &Output, uint64_t Value, bool Negative, uint32_t Base, bool Upper,
+		uint8_t Flags, int Width, int Precision)
+{
+	const char *pDigits = Upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char Digits[s_MaxDigits];
+	int NumDigits = 0;
+
+	// 32-bit values stay clear of the 64-bit division helpers
+	if (Value <= UINT32_MAX)
+	{
+		uint32_t Value32 = (uint32_t)Value;
+
+		do
+		{
+			Digits[NumDigits++] = pDigits[Value32 % Base];
+			Value32 /= Base;
+		} while (Value32 != 0);
+	}
+	else
+	{
+		do
+		{
+			Digits[NumDigits++] = pDigits[Value % Base];
+			Value /= Base;
+		} while (Value != 0);
+	}
+
+	// As printf, a zero precision prints nothing for zero
+	if ((Precision == 0) && (NumDigits == 1) && (Digits[0] == '0'))
+	{
+		NumDigits = 0;
+	}
+
+	int Zeros = (Precision > NumDigits) ? (Precision - NumDigits) : 0;
+	int Padding = Width - NumDigits - Zeros - (Negative ? 1 : 0);
+
+	// Zero flag is ignored with a precision, as printf
+	if ((Flags & s_FlagZero) && !(Flags & s_FlagLeft) && (Precision < 0))
+	{
+		Zeros += (Padding > 0) ? Padding : 0;
+		Padding = 0;
+	}
+
+	if (!(Flags & s_FlagLeft))
+	{
+		Output.Repeat(' ', Padding);
+	}
+
+	if (Negative)
+	{
+		Output.Put('-');
+	}
+
+	Output.Repeat('0', Zeros);
+
+	while (NumDigits > 0)
+	{
+		Output.Put(Digits[--NumDigits]);
+	}
+
+	if (Flags & s_FlagLeft)
+	{
+		Output.Repeat(' ', Padding);
+	}
+}
+
+/**
+ * @brief	Writes a string conversion
+ * @param	Precision	Maximum number of characters, negative if none given
+ */
+static void PutString(FormatOutput &Output, const char *pString, uint8_t Flags, int Width, int Precision)
+{
+	if (pString == nullptr)
+	{
+		pString = "(null)";
+	}
+
+	int Length = 0;
+
+	while (pString[Length] && ((Precision < 0) || (Length < Precision)))
+	{
+		Length++;
+	}
+
+	if (!(Flags & s_FlagLeft))
+	{
+		Output.Repeat(' ', Width - Length);
+	}
+
+	for (int Idx = 0; Idx < Length; Idx++)
+	{
+		Output.Put(pString[Idx]);
+	}
+
+	if (Flags & s_FlagLeft)
+	{
+		Output.Repeat(' ', Width - Length);
+	}
+}
+
+/**
+ * @brief	Parses a decimal number
+ */
+static int ParseNumber(const char *&pFormat)
+{
+	int Value = 0;
+
+	while ((*pFormat >= '0') && (*pFormat <= '9'))
+	{
+		Value = (Value * 10) + (*pFormat++ - '0');
+	}
+
+	return Value;
+}
+
+size_t Format_VPrint(char *pOut, size_t Size, const char *Format, va_list Args)
+{
+	FormatOutput Output = { pOut, Size, 0 };
+	const char *pFormat = Format;
+
+	while (*pFormat)
+	{
+		if (*pFormat != '%')
+		{
+			Output.Put(*pFormat++);
+			continue;
+		}
+
+		const char *pSpec = pFormat++;
+		uint8_t Flags = 0;
+		int Width = 0;
+		int Precision = -1;
+		int LongCount = 0;
+		int ShortCount = 0;
+
+		// Flags
+		while ((*pFormat == '-') || (*pFormat == '0'))
+		{
+			Flags |= (*pFormat++ == '-') ? s_FlagLeft : s_FlagZero;
+		}
+
+		// Width, negative from * means left justified
+		if (*pFormat == '*')
+		{
+			pFormat++;
+			Width = va_arg(Args, int);
+
+			if (Width < 0)
+			{
+				Flags |= s_FlagLeft;
+				Width = -Width;
+			}
+		}
+		else
+		{
+			Width = ParseNumber(pFormat);
+		}
+
+		// Precision, negative from * means none
+		if (*pFormat == '.')
+		{
+			pFormat++;
+
+			if (*pFormat == '*')
+			{
+				pFormat++;
+				Precision = va_arg(Args, int);
+				Precision = (Precision < 0) ? -1 : Precision;
+			}
+			else
+			{
+				Precision = ParseNumber(pFormat);
+			}
+		}
+
+		// Length modifiers, everything but ll is 32 bits on this target. Arguments of h
+		// and hh are promoted to int, they are narrowed back as printf does.
+		while ((*pFormat == 'h') || (*pFormat == 'l') || (*pFormat == 'z'))
+		{
+			LongCount += (*pFormat == 'l') ? 1 : 0;
+			ShortCount += (*pFormat++ == 'h') ? 1 : 0;
+		}
+
+		switch (*pFormat)
+		{
+		case 'd':
+		case 'i':
+		{
+			int64_t Value = (LongCount >= 2) ? va_arg(Args, long long) :
+					(LongCount == 1) ? va_arg(Args, long) : va_arg(Args, int);
+
+			if (LongCount == 0)
+			{
+				Value = (ShortCount >= 2) ? (signed char)Value : (ShortCount == 1) ? (short)Value : Value;
+			}
+
+			uint64_t Magnitude = (Value < 0) ? (0 - (uint64_t)Value) : (uint64_t)Value;
+			PutInteger(Output, Magnitude, (Value < 0), 10, false, Flags, Width, Precision);
+			break;
+		}
+
+		case 'u':
+		case 'x':
+		case 'X':
+		{
+			uint64_t Value = (LongCount >= 2) ? va_arg(Args, unsigned long long) :
+					(LongCount == 1) ? va_arg(Args, unsigned long) : va_arg(Args, unsigned int);
+
+			if (LongCount == 0)
+			{
+				Value = (ShortCount >= 2) ? (unsigned char)Value : (ShortCount == 1) ? (unsigned short)Value : Value;
+			}
+
+			PutInteger(Output, Value, false, (*pFormat == 'u') ? 10 : 16, (*pFormat == 'X'), Flags, Width, Precision);
+			break;
+		}
+
+		case 'p':
+			Output.Put('0');
+			Output.Put('x');
+			PutInteger(Output, (uintptr_t)va_arg(Args, void *), false, 16, false, s_FlagZero, sizeof(void *) * 2, -1);
+			break;
+
+		case 's':
+			PutString(Output, va_arg(Args, const char *), Flags, Width, Precision);
+			break;
+
+		case 'c':
+		{
+			char Character = (char)va_arg(Args, int);
+			Output.Repeat(' ', (Flags & s_FlagLeft) ? 0 : (Width - 1));
+			Output.Put(Character);
+			Output.Repeat(' ', (Flags & s_FlagLeft) ? (Width - 1) : 0);
+			break;
+		}
+
+		case '%':
+			Output.Put('%');
+			break;
+
+		default:
+			// Unsupported, copy the spec through so the mistake is visible
+			while (pSpec <= pFormat)
+			{
+				if (*pSpec == 0)
+				{
+					break;
+				}
+
+				Output.Put(*pSpec++);
+			}
+			break;
+		}
+
+		if (*pFormat)
+		{
+			pFormat++;
+		}
+	}
+
+	if (Size > 0)
+	{
+		pOut[(Output.Length < Size) ? Output.Length : (Size - 1)] = 0;
+	}
+
+	return Output.Length;
+}
+
+size_t Format_Print(char *pOut, size_t Size, const char *Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	size_t Length = Format_VPrint(pOut, Size, Format, Args);
+	va_end(Args);
+
+	return Length;
+}
@@ -0,0 +1,68 @@
+/*
+ * ntc.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "ntc.h"
+
+#include <stddef.h>
+
+// Codes between table entries, a power of two so the index is a shift
+static constexpr uint32_t s_StepShift = 7;
+static constexpr uint32_t s_Step = 1 << s_StepShift;
+
+// Tenths of a degree C every s_Step codes, from the Steinhart-Hart equation with
+// A = 1.129148e-3, B = 2.34125e-4 and C = 8.76741e-8, the coefficients of a typical
+// 10k probe. Clamped at the ends, which are outside the valid codes.
+static constexpr int16_t s_Table[] = {
+	1500, 1500, 1500, 1389, 1271, 1183, 1113, 1055,
+	1006, 963, 925, 892, 861, 833, 807, 783,
+	761, 740, 720, 701, 684, 667, 651, 636,
+	621, 607, 593, 580, 567, 555, 543, 532,
+	520, 509, 499, 488, 478, 468, 459, 449,
+	440, 431, 422, 413, 404, 396, 387, 379,
+	371, 362, 354, 347, 339, 331, 323, 316,
+	308, 301, 293, 286, 279, 272, 264, 257,
+	250, 243, 236, 229, 222, 215, 208, 201,
+	194, 187, 180, 173, 166, 159, 152, 144,
+	137, 130, 123, 116, 109, 101, 94, 87,
+	79, 72, 64, 56, 49, 41, 33, 25,
+	17, 8, 0, -9, -17, -26, -36, -45,
+	-55, -64, -74, -85, -96, -107, -118, -130,
+	-143, -156, -170, -184, -199, -216, -233, -252,
+	-273, -296, -322, -352, -388, -432, -492, -550,
+	-550,
+};
+
+static_assert(sizeof(s_Table) / sizeof(s_Table[0]) == (NTC_CODE_FULL_SCALE / s_Step) + 1,
+		"Every step of the code range needs an entry, and one for full scale");
+
+// Codes of 125 and -40 degrees C
+static constexpr uint16_t s_MinCode = 540;
+static constexpr uint16_t s_MaxCode = 15910;
+
+extern "C" {
+
+bool Ntc_ToTenths(uint16_t Code, int16_t *pTemperature)
+{
+	if ((Code < s_MinCode) || (Code > s_MaxCode))
+	{
+		return false;
+	}
+
+	size_t Idx = Code >> s_StepShift;
+	int32_t Offset = Code & (s_Step - 1);
+	int32_t Step = Offset * (s_Table[Idx + 1] - s_Table[Idx]);
+
+	// Rounded to the nearest tenth, either side of zero
+	Step = (Step >= 0) ? ((Step + (int32_t)(s_Step / 2)) / (int32_t)s_Step) :
+			-((-Step + (int32_t)(s_Step / 2)) / (int32_t)s_Step);
+
+	*pTemperature = (int16_t)(s_Table[Idx] + Step);
+
+	return true;
+}
+
+}
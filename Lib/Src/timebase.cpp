@@ -0,0 +1,48 @@
+/*
+ * timebase.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: mhamz
+ */
+
+#include "timebase.h"
+
+#include "stm32f1xx_hal.h"
+
+// Number of CYCCNT half periods elapsed. Its parity matches CYCCNT bit 31 whenever
+// it is up to date, so a reader can tell if it lags by one and correct for it
+// without locking.
+static volatile uint32_t s_Epoch = 0;
+
+extern "C" {
+
+uint64_t Timebase_GetCycles(void)
+{
+	uint32_t Epoch = s_Epoch;
+	uint32_t Cycles = DWT->CYCCNT;
+
+	if ((Epoch & 1) != (Cycles >> 31))
+	{
+		// Crossed a half period since the last update
+		Epoch++;
+	}
+
+	return ((uint64_t)(Epoch >> 1) << 32) | Cycles;
+}
+
+void Timebase_Update(void)
+{
+	uint32_t Epoch = s_Epoch;
+
+	if ((Epoch & 1) != (DWT->CYCCNT >> 31))
+	{
+		s_Epoch = Epoch + 1;
+	}
+}
+
+uint64_t Timebase_CyclesToUs(uint64_t Cycles)
+{
+	return Cycles / (SystemCoreClock / 1000000);
+}
+
+}
@@ -0,0 +1,30 @@
+/*
+ * FreeRTOS.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+#ifndef TESTS_STUB_FREERTOS_H_
+#define TESTS_STUB_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+
+typedef struct
+{
+	uint32_t Reserved;
+} StaticEventGroup_t;
+
+#define pdFALSE					((BaseType_t)0)
+#define pdTRUE					((BaseType_t)1)
+
+// Ticks are milliseconds
+#define pdMS_TO_TICKS(Ms)		((TickType_t)(Ms))
+
+#define portYIELD_FROM_ISR(Woken)	((void)(Woken))
+
+#endif /* TESTS_STUB_FREERTOS_H_ */
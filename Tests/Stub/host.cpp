@@ -0,0 +1,264 @@
+/*
+ * host.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+// Host stand-ins for what the logger calls outside itself. There is no logger task:
+// the test flushes from a thread of its own, so wakeups and event flags do nothing.
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+
+#include "stm32f1xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+
+#include "logger.h"
+#include "command.h"
+#include "crc.h"
+#include "journal.h"
+#include "timebase.h"
+
+DWT_Type Host_Dwt = {};
+SCB_Type Host_Scb = {};
+
+volatile uint32_t uwTick = 0;
+
+UART_HandleTypeDef huart1 = {};
+
+// Top of RAM, from the linker script on the target
+extern "C" uint32_t _estack;
+uint32_t _estack = 0;
+
+// Cycles are counted at the target's clock so rendered timestamps read the same
+static constexpr uint64_t s_CyclesPerUs = 72;
+
+static const std::chrono::steady_clock::time_point s_Start = std::chrono::steady_clock::now();
+
+extern "C" {
+
+void NVIC_SystemReset(void)
+{
+	abort();
+}
+
+uint64_t Timebase_GetCycles(void)
+{
+	auto Elapsed = std::chrono::steady_clock::now() - s_Start;
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Elapsed).count() * s_CyclesPerUs;
+}
+
+void Timebase_Update(void)
+{
+}
+
+uint64_t Timebase_CyclesToUs(uint64_t Cycles)
+{
+	return Cycles / s_CyclesPerUs;
+}
+
+void Crc_Reset(void)
+{
+}
+
+uint32_t Crc_Accumulate(const uint32_t *pWords, size_t NumWords)
+{
+	(void) pWords;
+	(void) NumWords;
+	return 0;
+}
+
+bool Journal_Append(Journal_EntryType Type, const void *pData, size_t Length)
+{
+	(void) Type;
+	(void) pData;
+	(void) Length;
+	return true;
+}
+
+bool Command_Register(const char *Name, Command_Handler Handler, const char *Usage)
+{
+	(void) Name;
+	(void) Handler;
+	(void) Usage;
+	return true;
+}
+
+osKernelState_t osKernelGetState(void)
+{
+	return osKernelRunning;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+	auto Elapsed = std::chrono::steady_clock::now() - s_Start;
+	return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(Elapsed).count();
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t Function, void *pArgument, const osThreadAttr_t *pAttributes)
+{
+	(void) Function;
+	(void) pArgument;
+	(void) pAttributes;
+	return nullptr;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+	return nullptr;
+}
+
+osStatus_t osDelay(uint32_t Ticks)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(Ticks));
+	return osOK;
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *pAttributes)
+{
+	(void) pAttributes;
+	return nullptr;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t Flags, uint32_t Set)
+{
+	(void) Flags;
+	return Set;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t Flags, uint32_t Clear)
+{
+	(void) Flags;
+	return Clear;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t Flags, uint32_t Wait, uint32_t Options, uint32_t Timeout)
+{
+	(void) Flags;
+	(void) Wait;
+	(void) Options;
+	(void) Timeout;
+	return 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t ClearCountOnExit, TickType_t TicksToWait)
+{
+	(void) ClearCountOnExit;
+	(void) TicksToWait;
+	return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t TaskToNotify)
+{
+	(void) TaskToNotify;
+	return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t TaskToNotify, BaseType_t *pHigherPriorityTaskWoken)
+{
+	(void) TaskToNotify;
+	(void) pHigherPriorityTaskWoken;
+}
+
+}
+
+// Sinks with hardware behind them, Logger_Init makes them but the test never calls it
+LoggerSink::LoggerSink(const char *Name, bool Enabled) :
+	m_Buffer(),
+	m_pName(Name),
+	m_Enabled(Enabled),
+	m_Cursor(0),
+	m_Dropped(0)
+{
+}
+
+const char *LoggerSink::GetName(void) const
+{
+	return m_pName;
+}
+
+void LoggerSink::SetEnabled(bool Enabled)
+{
+	m_Enabled = Enabled;
+}
+
+bool LoggerSink::IsEnabled(void) const
+{
+	return m_Enabled;
+}
+
+uint32_t LoggerSink::GetDropped(void) const
+{
+	return m_Dropped;
+}
+
+bool LoggerSink::IsAvailable(void) const
+{
+	return true;
+}
+
+UartLoggerSink::UartLoggerSink(const char *Name, bool Enabled, UART_HandleTypeDef *pUART) :
+	LoggerSink(Name, Enabled),
+	m_pUART(pUART)
+{
+}
+
+bool UartLoggerSink::IsBusy(void) const
+{
+	return false;
+}
+
+bool UartLoggerSink::Transmit(size_t Length)
+{
+	(void) Length;
+	return false;
+}
+
+UsbLoggerSink::UsbLoggerSink(const char *Name, bool Enabled) :
+	LoggerSink(Name, Enabled)
+{
+}
+
+bool UsbLoggerSink::IsAvailable(void) const
+{
+	return false;
+}
+
+bool UsbLoggerSink::IsBusy(void) const
+{
+	return false;
+}
+
+bool UsbLoggerSink::Transmit(size_t Length)
+{
+	(void) Length;
+	return false;
+}
+
+SemihostingLoggerSink::SemihostingLoggerSink(const char *Name, bool Enabled) :
+	LoggerSink(Name, Enabled),
+	m_Handle(-1)
+{
+}
+
+bool SemihostingLoggerSink::IsAvailable(void) const
+{
+	return false;
+}
+
+bool SemihostingLoggerSink::IsBusy(void) const
+{
+	return false;
+}
+
+bool SemihostingLoggerSink::Transmit(size_t Length)
+{
+	(void) Length;
+	return false;
+}
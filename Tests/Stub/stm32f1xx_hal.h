@@ -0,0 +1,131 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+#ifndef TESTS_STUB_STM32F1XX_HAL_H_
+#define TESTS_STUB_STM32F1XX_HAL_H_
+
+// Host stand-in for the HAL and CMSIS core, just what the logger uses. Threads play
+// the part of tasks, so everything here must be safe to call from several at once.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <thread>
+
+#define FLASH_BASE		0x08000000UL
+#define SRAM_BASE		0x20000000UL
+
+typedef struct
+{
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	volatile uint32_t CFSR;
+	volatile uint32_t HFSR;
+	volatile uint32_t MMFAR;
+	volatile uint32_t BFAR;
+} SCB_Type;
+
+extern DWT_Type Host_Dwt;
+extern SCB_Type Host_Scb;
+
+#define DWT		(&Host_Dwt)
+#define SCB		(&Host_Scb)
+
+typedef struct
+{
+	uint32_t Instance;
+} UART_HandleTypeDef;
+
+extern volatile uint32_t uwTick;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void NVIC_SystemReset(void) __attribute__((noreturn));
+
+#if defined(__cplusplus)
+}
+#endif
+
+// Each thread holds at most one reservation, like a core. STREX fails if the word
+// changed since LDREX, which is all the logger's retry loops rely on: the core also
+// fails it on an exception in between, which only costs them another pass.
+static thread_local volatile uint32_t *t_pReserved = nullptr;
+static thread_local uint32_t t_Reserved = 0;
+
+// Every few reservations the thread is switched out while holding it, as a task is by
+// an interrupt, so the failed STREX paths run even on a single core host. Odd, a record
+// takes two and an even period would only ever land on the same one.
+static constexpr uint32_t s_PreemptEvery = 7;
+static thread_local uint32_t t_Reservations = 0;
+
+static inline uint32_t __LDREXW(volatile uint32_t *pAddress)
+{
+	t_Reserved = __atomic_load_n(pAddress, __ATOMIC_SEQ_CST);
+	t_pReserved = pAddress;
+
+	if ((++t_Reservations % s_PreemptEvery) == 0)
+	{
+		std::this_thread::yield();
+	}
+
+	return t_Reserved;
+}
+
+static inline uint32_t __STREXW(uint32_t Value, volatile uint32_t *pAddress)
+{
+	if (t_pReserved != pAddress)
+	{
+		return 1;
+	}
+
+	uint32_t Expected = t_Reserved;
+	t_pReserved = nullptr;
+
+	return __atomic_compare_exchange_n(pAddress, &Expected, Value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 0 : 1;
+}
+
+static inline void __CLREX(void)
+{
+	t_pReserved = nullptr;
+}
+
+static inline void __DMB(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Threads are never in an interrupt and can't mask one
+static inline uint32_t __get_IPSR(void)
+{
+	return 0;
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+	return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t Primask)
+{
+	(void) Primask;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline uint32_t __get_PSP(void)
+{
+	return 0;
+}
+
+#endif /* TESTS_STUB_STM32F1XX_HAL_H_ */
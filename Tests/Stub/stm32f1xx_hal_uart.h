@@ -0,0 +1,14 @@
+/*
+ * stm32f1xx_hal_uart.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+#ifndef TESTS_STUB_STM32F1XX_HAL_UART_H_
+#define TESTS_STUB_STM32F1XX_HAL_UART_H_
+
+// UART_HandleTypeDef is in the stub stm32f1xx_hal.h
+#include "stm32f1xx_hal.h"
+
+#endif /* TESTS_STUB_STM32F1XX_HAL_UART_H_ */
@@ -0,0 +1,27 @@
+/*
+ * task.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+#ifndef TESTS_STUB_TASK_H_
+#define TESTS_STUB_TASK_H_
+
+#include "FreeRTOS.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+uint32_t ulTaskNotifyTake(BaseType_t ClearCountOnExit, TickType_t TicksToWait);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t TaskToNotify);
+
+void vTaskNotifyGiveFromISR(TaskHandle_t TaskToNotify, BaseType_t *pHigherPriorityTaskWoken);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TESTS_STUB_TASK_H_ */
@@ -0,0 +1,13 @@
+/*
+ * usbd_cdc_if.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+#ifndef TESTS_STUB_USBD_CDC_IF_H_
+#define TESTS_STUB_USBD_CDC_IF_H_
+
+#define CDC_DATA_FS_MAX_PACKET_SIZE		64
+
+#endif /* TESTS_STUB_USBD_CDC_IF_H_ */
@@ -0,0 +1,289 @@
+/*
+ * logger_stress.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: mhamz
+ */
+
+// Many producers against one flusher, on the host. Producer threads log through the
+// real arena and its LDREX/STREX reservation (see Stub/stm32f1xx_hal.h) while one
+// thread flushes, then every rendered line is checked: none torn or interleaved,
+// each producer's in the order it logged them, and no queued record lost.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+
+static constexpr LoggerModule s_DroppingModule(LogModuleId::Test);
+static constexpr LoggerModule s_EvictingModule(LogModuleId::Test, LogPolicy::OverwriteOldest);
+
+// Records each producer logs per run
+static constexpr uint32_t s_RecordsPerProducer = 20000;
+
+// Longest filler, varies record sizes so records land at every offset and pad the arena end
+static constexpr uint32_t s_MaxFiller = 40;
+
+static constexpr const char s_Filler[] = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz";
+
+static_assert(sizeof(s_Filler) > s_MaxFiller, "Filler must cover the longest record");
+
+// A corrupted arena can leave a record that is never committed, stopping the flusher
+// and every producer behind it. No record queued for this long fails the test.
+static constexpr auto s_StallTimeout = std::chrono::seconds(10);
+
+// Records queued by every producer, and producers still running
+static std::atomic<uint32_t> s_Progress(0);
+static std::atomic<uint32_t> s_Running(0);
+
+/**
+ * @class	Sink collecting everything rendered, never busy
+ */
+class CaptureSink : public LoggerSink
+{
+public:
+	CaptureSink(void) :
+		LoggerSink("capture", true)
+	{
+	}
+
+	bool IsBusy(void) const override
+	{
+		return false;
+	}
+
+	bool Transmit(size_t Length) override
+	{
+		m_Output.append((const char *)m_Buffer, Length);
+		return true;
+	}
+
+	std::string m_Output;
+};
+
+static CaptureSink s_Sink;
+
+/**
+ * @brief	What a producer logs and which of its records were queued
+ */
+struct Producer
+{
+	const LoggerModule *pModule;
+	std::vector<bool> Queued;
+	std::vector<uint32_t> Received;
+	size_t Retries;
+};
+
+/**
+ * @brief	Check word of a record, any byte torn from another record changes it
+ */
+static uint32_t CheckWord(uint32_t Id, uint32_t Sequence)
+{
+	uint32_t Hash = 2166136261u;
+
+	Hash = (Hash ^ Id) * 16777619u;
+	Hash = (Hash ^ Sequence) * 16777619u;
+
+	return Hash;
+}
+
+static void Produce(uint32_t Id, Producer *pProducer)
+{
+	for (uint32_t Sequence = 0; Sequence < s_RecordsPerProducer; Sequence++)
+	{
+		uint32_t Filler = (Sequence * 7 + Id) % s_MaxFiller;
+
+		// A full arena drops the record, the producer tries it again rather than skip
+		// ahead so every sequence number goes through the arena
+		while (!LOGGER.LogF(pProducer->pModule, LogLevel::Info, "p %lu s %lu c %08lx %.*s", (unsigned long)Id,
+				(unsigned long)Sequence, (unsigned long)CheckWord(Id, Sequence), (int)Filler, &s_Filler[Id % 26]))
+		{
+			pProducer->Retries++;
+			std::this_thread::yield();
+		}
+
+		pProducer->Queued[Sequence] = true;
+		s_Progress++;
+	}
+
+	s_Running--;
+}
+
+/**
+ * @brief	Checks one rendered line and files it under its producer
+ * @retval	false	Torn, interleaved, out of order or never logged
+ */
+static bool CheckLine(const std::string &Line, std::vector<Producer> &Producers)
+{
+	unsigned long Id, Sequence, Check;
+	int Consumed = 0;
+
+	if ((sscanf(Line.c_str(), "[%*u.%*u] Test: p %lu s %lu c %lx %n", &Id, &Sequence, &Check, &Consumed) != 3) ||
+		(Consumed == 0) || (Id >= Producers.size()) || (Sequence >= s_RecordsPerProducer) ||
+		(Check != CheckWord(Id, Sequence)))
+	{
+		return false;
+	}
+
+	uint32_t Filler = (Sequence * 7 + Id) % s_MaxFiller;
+	Producer &Owner = Producers[Id];
+
+	if ((Line.size() != (Consumed + Filler)) || (Line.compare(Consumed, Filler, &s_Filler[Id % 26], Filler) != 0) ||
+		!Owner.Queued[Sequence] || (!Owner.Received.empty() && (Owner.Received.back() >= Sequence)))
+	{
+		return false;
+	}
+
+	Owner.Received.push_back(Sequence);
+	return true;
+}
+
+/**
+ * @brief	Runs producers with the given modules against one flusher and checks the output
+ * @param	Complete	Every queued record must come out, nothing evicts
+ * @retval	false		A check failed
+ */
+static bool Run(const char *pName, const std::vector<const LoggerModule *> &Modules, bool Complete)
+{
+	std::vector<Producer> Producers(Modules.size());
+	std::vector<std::thread> Threads;
+	std::atomic<bool> Done(false);
+
+	for (size_t Idx = 0; Idx < Modules.size(); Idx++)
+	{
+		Producers[Idx].pModule = Modules[Idx];
+		Producers[Idx].Queued.assign(s_RecordsPerProducer, false);
+		Producers[Idx].Retries = 0;
+	}
+
+	s_Sink.m_Output.clear();
+
+	std::thread Flusher([&Done]()
+	{
+		while (!Done)
+		{
+			LOGGER.Flush();
+		}
+	});
+
+	s_Running = Producers.size();
+
+	for (size_t Idx = 0; Idx < Producers.size(); Idx++)
+	{
+		Threads.emplace_back(Produce, (uint32_t)Idx, &Producers[Idx]);
+	}
+
+	uint32_t Progress = s_Progress;
+	auto LastProgress = std::chrono::steady_clock::now();
+
+	while (s_Running > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		if (s_Progress != Progress)
+		{
+			Progress = s_Progress;
+			LastProgress = std::chrono::steady_clock::now();
+		}
+		else if ((std::chrono::steady_clock::now() - LastProgress) > s_StallTimeout)
+		{
+			// Threads are stuck for good, they can't be joined
+			printf("%s: stalled after %lu records\nFAILED\n", pName, (unsigned long)Progress);
+			fflush(stdout);
+			_Exit(1);
+		}
+	}
+
+	for (std::thread &Thread : Threads)
+	{
+		Thread.join();
+	}
+
+	Done = true;
+	Flusher.join();
+
+	// Producers are done, this drains what's left
+	LOGGER.Flush();
+
+	size_t Lines = 0;
+	size_t Bad = 0;
+
+	for (size_t Start = 0; Start < s_Sink.m_Output.size(); )
+	{
+		size_t End = s_Sink.m_Output.find("\r\n", Start);
+
+		if (End == std::string::npos)
+		{
+			printf("%s: output ends mid line\n", pName);
+			return false;
+		}
+
+		std::string Line = s_Sink.m_Output.substr(Start, End - Start);
+
+		if (!CheckLine(Line, Producers))
+		{
+			if (Bad++ < 8)
+			{
+				printf("%s: bad line \"%s\"\n", pName, Line.c_str());
+			}
+		}
+
+		Lines++;
+		Start = End + 2;
+	}
+
+	size_t Queued = 0;
+	size_t Lost = 0;
+	size_t Retries = 0;
+
+	for (const Producer &Entry : Producers)
+	{
+		size_t ProducerQueued = 0;
+
+		for (bool Queue : Entry.Queued)
+		{
+			ProducerQueued += Queue ? 1 : 0;
+		}
+
+		Queued += ProducerQueued;
+		Retries += Entry.Retries;
+		Lost += ProducerQueued - Entry.Received.size();
+	}
+
+	printf("%s: %zu producers queued %zu after %zu retries, flushed %zu, %zu bad, %zu evicted\n", pName,
+			Producers.size(), Queued, Retries, Lines, Bad, Lost);
+
+	return (Bad == 0) && (!Complete || (Lost == 0)) && (Lines > 0);
+}
+
+int main(void)
+{
+	LOGGER.AddSink(&s_Sink);
+
+	unsigned Cores = std::thread::hardware_concurrency();
+	size_t NumProducers = (Cores > 2) ? (Cores * 2) : 4;
+
+	std::vector<const LoggerModule *> Dropping(NumProducers, &s_DroppingModule);
+	std::vector<const LoggerModule *> Mixed;
+
+	// Evicting producers take the tail lock against the flusher
+	for (size_t Idx = 0; Idx < NumProducers; Idx++)
+	{
+		Mixed.push_back((Idx % 2) ? &s_EvictingModule : &s_DroppingModule);
+	}
+
+	bool Passed = Run("drop newest", Dropping, true);
+	Passed = Run("overwrite oldest", Mixed, false) && Passed;
+
+	printf("%s\n", Passed ? "PASSED" : "FAILED");
+
+	return Passed ? 0 : 1;
+}
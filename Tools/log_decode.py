@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""
+log_decode.py
+
+Decodes the binary log stream produced with LOG_BINARY defined in logger.h.
+
+Format strings live in the non-loaded .logfmt section of the firmware ELF, a
+frame only carries their offset plus the raw argument words. Pointers (module
+names and %s arguments) are resolved from the loaded sections of the same ELF.
+
+Timestamps are zigzag encoded DWT cycle deltas, rendered as seconds using --cpu-hz.
+Deltas can be negative, records logged from interrupts may be older than the one
+before them.
+
+Usage:
+    log_decode.py [--cpu-hz HZ] firmware.elf [capture.bin]
+
+Reads the capture from stdin when no file is given, e.g.
+    stty -F /dev/ttyACM0 115200 raw && log_decode.py Debug/TerrariumController.elf < /dev/ttyACM0
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+TEXT_FORMAT_ID = 0
+FLASH_BASE = 0x08000000
+
+FORMAT_SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t)?([diouxXcspn%])")
+
+
+class Elf:
+    """Minimal ELF32 little-endian reader, enough to find section contents"""
+
+    SHF_ALLOC = 0x2
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a 32-bit little-endian ELF" % path)
+
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+
+        headers = []
+        for idx in range(shnum):
+            name, stype, flags, addr, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + idx * shentsize)
+            headers.append((name, stype, flags, addr, offset, size))
+
+        strtab = headers[shstrndx]
+        self.sections = {}
+        self.loaded = []
+        for name, stype, flags, addr, offset, size in headers:
+            end = self.data.index(b"\0", strtab[4] + name)
+            sname = self.data[strtab[4] + name:end].decode()
+            contents = self.data[offset:offset + size] if stype != 8 else b""
+            self.sections[sname] = (addr, contents)
+            if flags & self.SHF_ALLOC and contents:
+                self.loaded.append((addr, contents))
+
+    def section(self, name):
+        return self.sections[name][1]
+
+    def string_at(self, address):
+        for base, contents in self.loaded:
+            if base <= address < base + len(contents):
+                start = address - base
+                end = contents.find(b"\0", start)
+                return contents[start:end if end >= 0 else None].decode(errors="replace")
+        return None
+
+
+def read_varint(payload, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = payload[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def render(elf, fmt, words):
+    """printf with 32-bit argument words, as the target would have done"""
+    args = iter(words)
+
+    def convert(match):
+        flags, width, precision, _, conv = match.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(next(args, 0))
+        if precision == "*":
+            precision = str(next(args, 0))
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+        value = next(args, None)
+        if value is None:
+            return "<missing>"
+        if conv in "di":
+            return (spec + "d") % (value - (1 << 32) if value & 0x80000000 else value)
+        if conv in "ouxX":
+            return (spec + conv) % value
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conv == "s":
+            text = elf.string_at(value)
+            return (spec + "s") % (text if text is not None else "<0x%08x>" % value)
+        if conv == "p":
+            return "0x%08x" % value
+        return match.group(0)
+
+    return FORMAT_SPEC.sub(convert, fmt)
+
+
+def decode(elf, stream, out, cpu_hz):
+    formats = elf.section(".logfmt")
+    cycles = 0
+    buffer = b""
+
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+
+        while len(buffer) >= 2:
+            if buffer[0] != FRAME_SYNC:
+                buffer = buffer[1:]
+                continue
+            length = buffer[1]
+            if len(buffer) < 2 + length:
+                break
+            payload = buffer[2:2 + length]
+
+            try:
+                delta, pos = read_varint(payload, 0)
+                delta = (delta >> 1) ^ -(delta & 1)
+                module_offset, pos = read_varint(payload, pos)
+                format_id, pos = read_varint(payload, pos)
+
+                if format_id == TEXT_FORMAT_ID:
+                    text = payload[pos:].decode(errors="replace")
+                else:
+                    words = []
+                    while pos < len(payload):
+                        word, pos = read_varint(payload, pos)
+                        words.append(word)
+                    end = formats.index(b"\0", format_id)
+                    text = render(elf, formats[format_id:end].decode(errors="replace"), words)
+            except (IndexError, ValueError):
+                # Lost sync, resume at the next sync byte
+                buffer = buffer[1:]
+                continue
+
+            buffer = buffer[2 + length:]
+            cycles += delta
+            us = cycles * 1000000 // cpu_hz
+            module = elf.string_at(FLASH_BASE + module_offset) or "?"
+            out.write("[%5d.%06d] %-8s %s\n" % (us // 1000000, us % 1000000, module + ":", text))
+            out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes binary logger output")
+    parser.add_argument("--cpu-hz", type=int, default=72000000, help="core clock the timestamps count")
+    parser.add_argument("elf", help="firmware ELF the capture was produced by")
+    parser.add_argument("capture", nargs="?", help="binary capture, stdin if omitted")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+
+    if args.capture:
+        with open(args.capture, "rb") as stream:
+            decode(elf, stream, sys.stdout, args.cpu_hz)
+    else:
+        decode(elf, sys.stdin.buffer, sys.stdout, args.cpu_hz)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())